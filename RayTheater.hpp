@@ -2,12 +2,29 @@
 #ifndef RAYTHEATER_H
 #define RAYTHEATER_H 1
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <climits>
 #include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <raylib.h>
@@ -27,6 +44,10 @@ namespace Theater {
 
 class Stage; // <== "needed by some classes before Stage is defined
 class ActorComponent;
+class SnapshotWriter;
+class SnapshotReader;
+class Transform2D;
+class FrameArena;
 
 #ifdef STAGE_ATTRIBUTE
 #undef STAGE_ATTRIBUTE
@@ -82,6 +103,10 @@ typedef struct Play {
    * at the stage */
   int mouseY = 0;
 
+  /** @brief Scratch memory, that is freed at the start of the frame after
+   * the next one (see FrameArena). Nothing needs to be released. */
+  FrameArena *arena = NULL;
+
   /** @brief The available Stage Width in PX */
   int stageWidth = 0;
 
@@ -122,6 +147,30 @@ typedef struct Play {
 
 } Play;
 
+// BM: ActorHandle - Struct
+//==============================================================================
+/** @brief Refers to an Actor on the Stage without pointing at it. Once the
+ * Actor left the Stage, the handle resolves to NULL (see Stage::GetActor),
+ * even if a new Actor is put on the Stage at the same address.
+ *
+ * index is a slot of the Stage; generation counts, how often that slot was
+ * reused (0 = a handle to no Actor at all).
+ */
+struct ActorHandle {
+  unsigned int index;
+  unsigned int generation;
+
+  ActorHandle() : index(0), generation(0) {}
+  ActorHandle(unsigned int i, unsigned int g) : index(i), generation(g) {}
+
+  bool IsNull() const { return generation == 0; }
+
+  bool operator==(const ActorHandle &o) const {
+    return index == o.index && generation == o.generation;
+  }
+  bool operator!=(const ActorHandle &o) const { return !(*this == o); }
+};
+
 // BM: Actor - Class
 //==============================================================================
 class Actor {
@@ -129,7 +178,7 @@ class Actor {
   friend ActorComponent;
 
 public:
-  Actor() : _attributes() {}
+  Actor() : _attributes(), _stageIndex(-1) {}
   bool hasAttribute(Attributes attr) {
     return _attributes.find(attr) != _attributes.end();
   }
@@ -138,8 +187,22 @@ private:
   virtual void OnStageEnter(Play) {}
   virtual void OnStageLeave(Play) {}
 
+  /** @brief called, when the window was resized (e.g. to lay out UI anew) */
+  virtual void OnStageResize(Play) {}
+
+  /** @brief called, when the Stage takes a snapshot. Write everything the
+   * Actor needs, to return to its current state later on */
+  virtual void OnSnapshotSave(SnapshotWriter &) {}
+
+  /** @brief called, when the Stage restores a snapshot. Read back, what
+   * was written in OnSnapshotSave (in the same order) */
+  virtual void OnSnapshotLoad(SnapshotReader &) {}
+
 private:
   std::unordered_set<Attributes> _attributes;
+
+  // Position in the Stages actor list (-1 = not on stage)
+  int _stageIndex;
 };
 
 // BM: ActorComponent - Class
@@ -151,43 +214,324 @@ public:
   ActorComponent(Actor *ac, Attributes at) { ac->_attributes.insert(at); }
 };
 
+// BM: TransformStore - Struct
+//==============================================================================
+/** @brief The transforms of all Transform2D Actors on the Stage, stored as
+ * one array per value. Entry i of each array belongs to owners[i].
+ * Systems working on many Actors at once can read the current and world
+ * values and write the requested ones (next...) directly. After writing,
+ * call MarkDirty(i) (or MarkAllDirty()), so the Stage picks them up.
+ */
+struct TransformStore {
+  // Local values at the start of the cycle (relative to the parent)
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> rotation;
+  std::vector<float> scale;
+
+  // Local values requested for the next cycle
+  std::vector<float> nextX;
+  std::vector<float> nextY;
+  std::vector<float> nextRotation;
+  std::vector<float> nextScale;
+
+  // Values after applying all parents, at the start of the cycle
+  std::vector<float> worldX;
+  std::vector<float> worldY;
+  std::vector<float> worldRotation;
+  std::vector<float> worldScale;
+
+  std::vector<Transform2D *> owners;
+
+  size_t Size() const { return owners.size(); }
+
+  /** @brief tells the Stage, that the requested values of entry i changed */
+  void MarkDirty(size_t i);
+
+  /** @brief tells the Stage, that the requested values of (nearly) all
+   * entries changed */
+  void MarkAllDirty() { allDirty = true; }
+
+  // Entries changed since the last cycle
+  std::vector<Transform2D *> dirty;
+  bool allDirty = false;
+};
+
 // BM: ActorComponent - Transform2D - Class
 //==============================================================================
 class Transform2D : ActorComponent {
   friend Stage;
+  friend TransformStore;
+  friend class TweenEngine;
 
 public:
   Transform2D(Actor *a)
-      : ActorComponent(a, TRANSFORMABLE), _loc({0.0f, 0.0f}),
-        loc({0.0f, 0.0f}){};
+      : ActorComponent(a, TRANSFORMABLE), loc({0.0f, 0.0f}), rotation(0),
+        scale(1), _loc({0.0f, 0.0f}), _rotation(0), _scale(1), _parent(NULL),
+        _children(), _depth(0), _dirty(false), _store(NULL), _storeIndex(0){};
+
+  // Copies don't take over the place in the hierarchy or on the Stage
+  Transform2D(const Transform2D &o)
+      : ActorComponent(o), loc(o.getLoc()), rotation(o.getRotation()),
+        scale(o.getScale()), _loc(o.getNextLoc()),
+        _rotation(o.getNextRotation()), _scale(o.getNextScale()),
+        _parent(NULL), _children(), _depth(0), _dirty(false), _store(NULL),
+        _storeIndex(0) {}
+
+  Transform2D &operator=(const Transform2D &o) {
+    setLoc(o.getNextLoc());
+    setRotation(o.getNextRotation());
+    setScale(o.getNextScale());
+    return *this;
+  }
+
+  ~Transform2D();
 
   /** @brief privides the Actors location, at the star of the cycle
+   * (relative to its parent, if it has one)
    * @return the actors location
    */
-  Vector2 getLoc() { return Vector2(loc); }
+  Vector2 getLoc() const {
+    if (_store != NULL)
+      return Vector2{_store->x[_storeIndex], _store->y[_storeIndex]};
+    return Vector2(loc);
+  }
 
   /** @brief Requests the Actor to change its location at the beginning
    * of the next Cycle
-   * @param l the new Location, the Actor should move to
+   * @param l the new Location, the Actor should move to (relative to its
+   * parent, if it has one)
    */
   void setLoc(Vector2 l) {
+    if (_store != NULL) {
+      _store->nextX[_storeIndex] = l.x;
+      _store->nextY[_storeIndex] = l.y;
+      _store->MarkDirty(_storeIndex);
+      return;
+    }
+
     this->_loc.x = l.x;
     this->_loc.y = l.y;
   }
 
+  /** @return rotation in degrees, at the start of the cycle */
+  float getRotation() const {
+    return _store != NULL ? _store->rotation[_storeIndex] : rotation;
+  }
+
+  /** @brief Requests the Actor to change its rotation (in degrees) at the
+   * beginning of the next Cycle */
+  void setRotation(float degrees) {
+    if (_store != NULL) {
+      _store->nextRotation[_storeIndex] = degrees;
+      _store->MarkDirty(_storeIndex);
+      return;
+    }
+
+    _rotation = degrees;
+  }
+
+  /** @return scale, at the start of the cycle */
+  float getScale() const {
+    return _store != NULL ? _store->scale[_storeIndex] : scale;
+  }
+
+  /** @brief Requests the Actor to change its scale at the beginning of the
+   * next Cycle */
+  void setScale(float s) {
+    if (_store != NULL) {
+      _store->nextScale[_storeIndex] = s;
+      _store->MarkDirty(_storeIndex);
+      return;
+    }
+
+    _scale = s;
+  }
+
+  /** @return location on the Stage, after applying all parents */
+  Vector2 getWorldLoc() const;
+
+  /** @return rotation in degrees, after applying all parents */
+  float getWorldRotation() const;
+
+  /** @return scale, after applying all parents */
+  float getWorldScale() const;
+
+  /** @brief Attaches the Actor to a parent. From now on, its location,
+   * rotation and scale are relative to the parent.
+   * @param parent - NULL = detach from the current parent
+   * @return false = the parent is a child of this Actor
+   */
+  bool setParent(Transform2D *parent);
+
+  /** @return the parent (NULL = none) */
+  Transform2D *getParent() const { return _parent; }
+
 private:
-  // Values, that the Actor is currently at
+  // Values, that the Actor is currently at (while not on the Stage)
   Vector2 loc;
+  float rotation;
+  float scale;
 
-  // Values, that the Actor should be next frame
+  // Values, that the Actor should be next frame (while not on the Stage)
   Vector2 _loc;
+  float _rotation;
+  float _scale;
+
+  Transform2D *_parent;
+  std::vector<Transform2D *> _children;
+  unsigned int _depth;
+  bool _dirty;
+
+  // While on the Stage, the values live in the Stages TransformStore
+  TransformStore *_store;
+  unsigned int _storeIndex;
+
+  Vector2 getNextLoc() const {
+    if (_store != NULL)
+      return Vector2{_store->nextX[_storeIndex], _store->nextY[_storeIndex]};
+    return _loc;
+  }
+
+  float getNextRotation() const {
+    return _store != NULL ? _store->nextRotation[_storeIndex] : _rotation;
+  }
 
-  void FlipTransform2DStates() {
-    loc.x = _loc.x;
-    loc.y = _loc.y;
+  float getNextScale() const {
+    return _store != NULL ? _store->nextScale[_storeIndex] : _scale;
   }
+
+  void setDepth(unsigned int depth);
+  void computeWorld();
+  void leaveStore();
 };
 
+// BM: ActorComponent - Transform2D - Implementation
+//==============================================================================
+inline void TransformStore::MarkDirty(size_t i) {
+  Transform2D *t = owners[i];
+  if (!t->_dirty) {
+    t->_dirty = true;
+    dirty.push_back(t);
+  }
+}
+
+inline Transform2D::~Transform2D() {
+  setParent(NULL);
+  for (Transform2D *child : _children) {
+    child->_parent = NULL;
+    child->setDepth(0);
+    if (child->_store != NULL)
+      child->_store->MarkDirty(child->_storeIndex);
+  }
+}
+
+inline bool Transform2D::setParent(Transform2D *parent) {
+  if (parent == _parent)
+    return true;
+
+  for (Transform2D *p = parent; p != NULL; p = p->_parent)
+    if (p == this) {
+      std::cerr << "Can't attach a Transform2D to one of its children"
+                << std::endl;
+      return false;
+    }
+
+  if (_parent != NULL) {
+    std::vector<Transform2D *> &siblings = _parent->_children;
+    for (size_t a = 0; a < siblings.size(); a++)
+      if (siblings[a] == this) {
+        siblings[a] = siblings.back();
+        siblings.pop_back();
+        break;
+      }
+  }
+
+  _parent = parent;
+  if (parent != NULL)
+    parent->_children.push_back(this);
+
+  setDepth(parent != NULL ? parent->_depth + 1 : 0);
+  if (_store != NULL)
+    _store->MarkDirty(_storeIndex);
+  return true;
+}
+
+inline void Transform2D::setDepth(unsigned int depth) {
+  _depth = depth;
+  for (Transform2D *child : _children)
+    child->setDepth(depth + 1);
+}
+
+inline Vector2 Transform2D::getWorldLoc() const {
+  if (_store != NULL)
+    return Vector2{_store->worldX[_storeIndex], _store->worldY[_storeIndex]};
+  if (_parent == NULL)
+    return getLoc();
+
+  Vector2 origin = _parent->getWorldLoc();
+  float rad = _parent->getWorldRotation() * DEG2RAD;
+  float s = _parent->getWorldScale();
+  Vector2 l = getLoc();
+  return Vector2{origin.x + (l.x * std::cos(rad) - l.y * std::sin(rad)) * s,
+                 origin.y + (l.x * std::sin(rad) + l.y * std::cos(rad)) * s};
+}
+
+inline float Transform2D::getWorldRotation() const {
+  if (_store != NULL)
+    return _store->worldRotation[_storeIndex];
+  if (_parent == NULL)
+    return getRotation();
+  return _parent->getWorldRotation() + getRotation();
+}
+
+inline float Transform2D::getWorldScale() const {
+  if (_store != NULL)
+    return _store->worldScale[_storeIndex];
+  if (_parent == NULL)
+    return getScale();
+  return _parent->getWorldScale() * getScale();
+}
+
+// Takes the values back from the store, once the Actor leaves the Stage
+inline void Transform2D::leaveStore() {
+  loc = getLoc();
+  rotation = getRotation();
+  scale = getScale();
+  _loc = getNextLoc();
+  _rotation = getNextRotation();
+  _scale = getNextScale();
+  _store = NULL;
+  _dirty = false;
+}
+
+// Updates the world values in the store, from the current local values and
+// the parents world values
+inline void Transform2D::computeWorld() {
+  TransformStore &ts = *_store;
+  unsigned int i = _storeIndex;
+
+  if (_parent == NULL) {
+    ts.worldX[i] = ts.x[i];
+    ts.worldY[i] = ts.y[i];
+    ts.worldRotation[i] = ts.rotation[i];
+    ts.worldScale[i] = ts.scale[i];
+    return;
+  }
+
+  Vector2 origin = _parent->getWorldLoc();
+  float parentRotation = _parent->getWorldRotation();
+  float parentScale = _parent->getWorldScale();
+  float rad = parentRotation * DEG2RAD;
+  float c = std::cos(rad);
+  float s = std::sin(rad);
+
+  ts.worldX[i] = origin.x + (ts.x[i] * c - ts.y[i] * s) * parentScale;
+  ts.worldY[i] = origin.y + (ts.x[i] * s + ts.y[i] * c) * parentScale;
+  ts.worldRotation[i] = parentRotation + ts.rotation[i];
+  ts.worldScale[i] = parentScale * ts.scale[i];
+}
+
 // BM: ActorComponent - Ticking - Class
 //==============================================================================
 class Ticking : ActorComponent {
@@ -216,10 +560,30 @@ public:
    * @param layer
    */
   void SetRenderLayer(int layer) { this->_zindex = layer; }
+  int GetRenderLayer() { return this->_zindex; }
+
+  /** @brief tells the Stage, that the Actor looks different now. Only needed
+   * for Actors on a cached render layer (see Stage::CacheRenderLayer)
+   */
+  void Invalidate() { _invalidated = true; }
+
+  /** @brief Sets the view layers (bits), the Actor is drawn on. A Viewport
+   * only draws Actors, that share a bit with its layerMask (default 1)
+   */
+  void SetViewLayers(unsigned int layers) { _viewLayers = layers; }
+
+  /** @brief Sets the area (in Stage coordinates), the Actor draws into.
+   * Viewports skip Actors outside their view. An empty area (default) is
+   * never skipped.
+   */
+  void SetCullBounds(Rectangle bounds) { _cullBounds = bounds; }
 
 private:
   int _renderListIndex = -1;
   int _zindex = 0;
+  bool _invalidated = false;
+  unsigned int _viewLayers = 1;
+  Rectangle _cullBounds = {0, 0, 0, 0};
   virtual void OnDraw(Play) = 0;
 };
 
@@ -272,9 +636,142 @@ private:
 
 private:
   friend class Stage;
+  friend class SnapshotWriter;
+  friend class SnapshotReader;
   void stageUpdate(Play p);
 };
 
+// BM: Snapshot - Class
+//=============================================================================
+/** @brief Given to Actor::OnSnapshotSave, to write the Actors state into a
+ * Stage-snapshot */
+class SnapshotWriter {
+  friend Stage;
+
+public:
+  /** @brief appends any trivially copyable value (no pointers!) */
+  template <typename T> void Write(const T &v) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be written to a "
+                  "snapshot");
+    WriteBytes(&v, sizeof(T));
+  }
+
+  /** @brief appends the state of a CountdownTimer (not its handlers) */
+  void Write(const CountdownTimer &t);
+
+  /** @brief appends raw bytes */
+  void WriteBytes(const void *data, size_t size);
+
+private:
+  SnapshotWriter(std::vector<unsigned char> *buffer) : _buffer(buffer) {}
+  std::vector<unsigned char> *_buffer;
+};
+
+/** @brief Given to Actor::OnSnapshotLoad, to read back what was written
+ * by Actor::OnSnapshotSave */
+class SnapshotReader {
+  friend Stage;
+
+public:
+  /** @brief reads a value written with SnapshotWriter::Write
+   * @return false = not enough data left */
+  template <typename T> bool Read(T &v) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable values can be read from a "
+                  "snapshot");
+    return ReadBytes(&v, sizeof(T));
+  }
+
+  /** @brief restores the state of a CountdownTimer (not its handlers) */
+  bool Read(CountdownTimer &t);
+
+  /** @brief reads raw bytes
+   * @return false = not enough data left */
+  bool ReadBytes(void *data, size_t size);
+
+  /** @return number of bytes, that can still be read */
+  size_t Remaining() { return _size - _pos; }
+
+private:
+  SnapshotReader(const unsigned char *data, size_t size)
+      : _data(data), _size(size), _pos(0) {}
+  const unsigned char *_data;
+  size_t _size;
+  size_t _pos;
+};
+
+// Snapshots are flat and contain no pointers, so they can be written to a file
+// and memory-mapped back in. Values use the byte order of the machine.
+#define RAYTHEATER_SNAPSHOT_VERSION 4
+
+struct SnapshotHeader {
+  char magic[4];
+  unsigned int version;
+  unsigned int size;
+  unsigned int actorCount;
+  unsigned int flags;
+};
+
+struct SnapshotActorRecord {
+  // Record + Actor-data, without the padding up to the next 4 byte boundary
+  unsigned int size;
+  unsigned int components;
+  // ActorHandle of the Actor, the record belongs to
+  unsigned int handleIndex;
+  unsigned int handleGeneration;
+  unsigned long long attributes;
+  int zindex;
+  int visible;
+  Vector2 loc;
+  Vector2 nextLoc;
+  float rotation;
+  float nextRotation;
+  float scale;
+  float nextScale;
+};
+
+enum SnapshotFlags { SNAPSHOT_PAUSED = 1 << 0 };
+
+enum SnapshotComponents {
+  SNAPSHOT_TICKING = 1 << 0,
+  SNAPSHOT_TRANSFORM2D = 1 << 1,
+  SNAPSHOT_VISIBLE = 1 << 2
+};
+
+// BM: InputStream - Class
+//=============================================================================
+/** @brief Hooks into the input of each cycle. Can be used to record the
+ * input, that a Play receives, or to feed it a recorded one instead.
+ */
+class InputStream {
+  friend Stage;
+
+private:
+  /** @brief called once, before the first Scene starts */
+  virtual void OnPlayStart(Play &) {}
+
+  /** @brief called each cycle, after the Stage has read the input and
+   * deltaTime, but before any Actor ticked. (In headless mode, the Play
+   * contains no input)
+   *
+   * @param p - may be changed to replace the cycles input
+   * @return false = end the Play (e.g. a recording ran out)
+   */
+  virtual bool OnInput(Play &p) = 0;
+
+  /** @brief called each cycle, a transition to another Scene is pending,
+   * before OnInput. Lets recordings keep the cycle, the Scene switched in.
+   *
+   * @param preloaded - true = the next Scene is preloaded
+   * @return true = switch now (the Stage waits for the preload, if needed)
+   */
+  virtual bool OnSceneSwitch(Play &, bool preloaded) { return preloaded; }
+
+  /** @brief called once, after the Play ended */
+  virtual void OnPlayEnd(Play &) {}
+};
+
 // BM: Scene - Class
 //=============================================================================
 class Scene {
@@ -287,757 +784,3643 @@ public:
   virtual void OnWindowDraw(Play) {}
   virtual void OnEnd(Play) {}
 
+  /** @brief called, when another Scene was pushed on top of this one */
+  virtual void OnSuspend(Play) {}
+
+  /** @brief called, when the Scene on top of this one ended */
+  virtual void OnResume(Play) {}
+
+  /** @brief called on a background thread, before the Scene starts.
+   * Used for the expensive part of setting up the Scene (reading files,
+   * decoding, generating data), so OnStart only needs to upload to the GPU
+   * and add the Actors to the Stage. Must not touch the Stage, the window
+   * or the GPU.
+   */
+  virtual void OnPreload() {}
+
   void TransitionTo(Scene *s) {
     _followup = s;
     _transitionRequested = true;
+    _pushRequested = false;
+  }
+
+  /** @brief Starts the Scene s on top of this one. This Scene is suspended:
+   * its Actors stay on the Stage, but don't tick and aren't drawn, until s
+   * ends (via TransitionTo(NULL)).
+   */
+  void PushScene(Scene *s) {
+    if (s == NULL)
+      return;
+
+    _followup = s;
+    _transitionRequested = true;
+    _pushRequested = true;
   }
 
   Scene *followup() { return _followup; }
 
+  /** @brief reports the progress of OnPreload (0 - 1) */
+  void PreloadProgress(float progress) { _preload.progress = progress; }
+
+  /** @return the progress of OnPreload (0 - 1) */
+  float PreloadProgress() { return _preload.progress; }
+
+  /** @return true = OnPreload has finished */
+  bool IsPreloaded() { return _preload.state == PRELOAD_DONE; }
+
 private:
+  enum PreloadState { PRELOAD_NONE, PRELOAD_RUNNING, PRELOAD_DONE };
+
+  // Written by a worker, read by the main thread. Copies start unloaded.
+  struct Preload {
+    std::atomic<int> state;
+    std::atomic<float> progress;
+    Preload() : state(PRELOAD_NONE), progress(0) {}
+    Preload(const Preload &) : Preload() {}
+    Preload &operator=(const Preload &) { return *this; }
+  };
+
   bool _transitionRequested = false;
+  bool _pushRequested = false;
   Scene *_followup = NULL;
+  Preload _preload;
 
+  // Once a transition is pending, the Scene only waits for the next one to
+  // be preloaded; OnUpdate is not called anymore
   bool Tick(Play p) {
-    OnUpdate(p);
+    if (!_transitionRequested)
+      OnUpdate(p);
     return !_transitionRequested;
   }
 
   Scene *Unload(Play p) {
     OnEnd(p);
     _transitionRequested = false;
+    _preload.state = PRELOAD_NONE;
+    _preload.progress = 0;
     return _followup;
   }
+
+  // Claims the preload for the caller.
+  // @return false = it is already running or done
+  bool beginPreload() {
+    int expected = PRELOAD_NONE;
+    return _preload.state.compare_exchange_strong(expected, PRELOAD_RUNNING);
+  }
+
+  void runPreload() {
+    OnPreload();
+    _preload.progress = 1;
+    _preload.state = PRELOAD_DONE;
+  }
 };
 
-// BM: Stage - Class
+// BM: Actor - Component lookup
 //=============================================================================
-class Stage {
-  friend class Builder;
+/** @brief resolves the Component C of an Actor. Uses a static cast, if T is
+ * known to implement C, a dynamic cast otherwise (e.g. for plain Actor*)
+ * @return the Component or NULL, if the Actor does not implement it
+ */
+template <typename C, typename T>
+inline C *actorComponent(T *a, std::true_type) {
+  return static_cast<C *>(a);
+}
 
-public:
-  ~Stage() { _scene = NULL; }
+template <typename C, typename T>
+inline C *actorComponent(T *a, std::false_type) {
+  return dynamic_cast<C *>(a);
+}
 
-  /** @brief Changes the Color of the Border, that is show, when the window is
-   * scaled to an aspect ratio different, than the Stages
-   */
-  void BorderColor(Color);
+template <typename C, typename T> inline C *actorComponent(T *a) {
+  return actorComponent<C>(a, std::is_base_of<C, T>());
+}
 
-  /** @brief Background-Color of the stage. (Each frame, the stage is cleared
-   * to this color.
+// BM: WorkerPool - Class
+//=============================================================================
+/** @brief A small pool of background threads, owned by the Stage.
+ * Threads are only started, once the first job is given to the pool.
+ */
+class WorkerPool {
+public:
+  /** @param threads - number of threads (0 = pick one based on the CPU) */
+  WorkerPool(unsigned int threads = 0);
+  ~WorkerPool();
+
+  /** @brief runs the given job on one of the pools threads */
+  void Run(std::function<void()> job);
+
+  /** @brief splits [0, count) into ranges of at least minChunk elements and
+   * runs job(begin, end) for each of them, on the pools threads and the
+   * calling one. Returns once all ranges are done.
+   * The ranges are queued ahead of other jobs, and the calling thread takes
+   * over all ranges, no worker has started yet, so it never waits behind
+   * long running jobs. (Must not be called from one of the pools threads)
    */
-  void BackgroundColor(Color);
+  void ParallelFor(size_t count, size_t minChunk,
+                   std::function<void(size_t, size_t)> job);
 
-  /** @brief Registers an Actor as being on the stage
-   *
-   * @param T any class that implement Theater::Actor
-   * @param a - reference that the Stage will use to adress the Actor
-   */
-  template <typename T> void AddActor(T *a);
+  /** @return number of threads, the pool works with */
+  unsigned int Threads();
 
-  /** @brief Marks any Actor as "DEAD", meaning, it will be removed from the
-   * stage between cycles
-   *
-   * @param a the pointer to the actor to remove (Must be the same value as
-   * given in AddActor)
-   */
-  template <typename T> void RemoveActor(T *a);
+  /** @return number of jobs waiting or running */
+  unsigned int Pending();
 
-  /** @brief Pauses all Ticking Actors */
-  void Pause();
+private:
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  unsigned int _size;
+  bool _stopping;
+  unsigned int _running;
+  std::vector<std::thread> _threads;
+  std::deque<std::function<void()>> _jobs;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+
+  void work();
+  void push(std::function<void()> job, bool front);
+};
 
-  /**  @brief Continues to run all Ticking Actors */
-  void UnPause();
+// BM: ResourceCache - Class
+//=============================================================================
+// Max number of resources uploaded to the GPU per cycle
+#ifndef RESOURCE_UPLOADS_PER_CYCLE
+#define RESOURCE_UPLOADS_PER_CYCLE 4
+#endif
 
-  /** @brief By default Actors are invisible / Not rendered
-   * use this function to make it visible (Add it to the Stages render-list)
-   *
-   * @tparam T any class that implements Theater::Actor and Theater::Visible
-   * @return true on success ; false == to many Actors are already on stage or
-   * you called this function during rendering
-   */
-  template <typename T> bool MakeActorVisible(T *);
+// Bytes that loaded, but no longer used resources may occupy, before the
+// least recently used ones are unloaded
+#ifndef RESOURCE_BUDGET
+#define RESOURCE_BUDGET (256 * 1024 * 1024)
+#endif
 
-  /** @brief removes any visible Actor from the stages render-list
-   *
-   * @tparam T any class that implements Theater::Visible
-   */
-  template <typename T> void MakeActorInvisible(T *);
+/** @brief References a resource in the Stages ResourceCache.
+ * A default constructed handle references nothing. */
+template <typename T> struct ResourceHandle {
+  unsigned int slot = 0;
+  unsigned int generation = 0;
+};
 
-  /**
-   * @brief Allows for adding custom Attributes to an Actor on the Stage
-   *
-   * @return - true = attribute added; false = Actor not on stage or used
-   * illegal Attribute
-   */
-  bool AddActorAttribute(Actor *, Attributes);
+typedef ResourceHandle<Texture2D> TextureHandle;
+typedef ResourceHandle<Font> FontHandle;
 
-  /**
-   * @brief Removes a custom Attribute from an Actor on the Stage
-   *
-   * @return - true = attribute removed; false = Actor not on stage or used
-   illegal
-   * Attribute
+/** @brief Loads, shares and unloads Textures and Fonts for the Stage.
+ *
+ * Files are read and decoded on the Stages WorkerPool. Only the upload to
+ * the GPU happens on the main thread, at the start of each cycle.
+ * Resources are identified by their path, so loading the same file twice
+ * gives the same resource. Each Acquire must be matched with a Release.
+ * Resources no longer used are kept, until the RESOURCE_BUDGET is exceeded.
+ */
+class ResourceCache {
+  friend Stage;
 
-   */
-  bool RemoveActorAttribute(Actor *, Attributes);
+public:
+  ResourceCache(std::shared_ptr<WorkerPool> workers);
+  ~ResourceCache();
 
-  /**
-   * @brief gets an unordered_set of Actors all having the requested Attributes
-   *
-   * @param attr
+  /** @brief starts loading the Texture at the given path in the background
+   * (or references the already loaded one)
+   * @return handle to pass to GetTexture and Release
    */
-  std::unordered_set<Actor *> GetActorsWithAttribute(Attributes attr);
+  TextureHandle AcquireTexture(const char *path);
 
-private:
-  Stage(int width, int height, float scale = 1.0);
+  /** @brief starts loading the Font at the given path in the background
+   * (or references the already loaded one)
+   * @param fontSize - size in pixels, the glyphs are rendered at
+   * @return handle to pass to GetFont and Release
+   */
+  FontHandle AcquireFont(const char *path, int fontSize = 32);
 
-  RenderNode<Visible> _renderNodes[ACTORLIMIT];
-  unsigned int _renderNodeCnt;
-  RenderNode<Visible> _renderNodeRoot;
+  /** @brief adds another reference to an already acquired resource */
+  template <typename T> void Acquire(ResourceHandle<T> h);
 
-  const char *_stageTitle;
-  float _stageWidth;
-  float _stageHeight;
-  float _stageScale;
-  RenderTexture2D _stage;
-  Scene *_scene;
-  Rectangle _viewportRect;
-  Rectangle _stageRect;
-  Vector2 _viewportOrigin;
+  /** @brief gives back a reference. Once no references are left, the
+   * resource may be unloaded */
+  template <typename T> void Release(ResourceHandle<T> h);
 
-  Color _borderColor;
-  Color _backgroundColor;
+  /** @return true = the resource is loaded and on the GPU */
+  template <typename T> bool IsReady(ResourceHandle<T> h);
 
-  Theater::Play _play;
+  /** @return true = the handle still references a resource */
+  template <typename T> bool IsValid(ResourceHandle<T> h);
 
-  bool _rendering;
-  bool _sceneUnloading;
-  bool _tickingPaused;
+  /** @return the Texture (an empty Texture with id 0, until it is ready) */
+  Texture2D GetTexture(TextureHandle h);
 
-  std::unordered_set<Actor *> _actorsToClear;
-  std::unordered_set<Ticking *> _handle_TICKING;
-  std::unordered_set<Transform2D *> _handle_TRANSFORMABLE;
-  std::unordered_set<Actor *> _handle_DEAD;
+  /** @return the Font (RayLibs default Font, until it is ready) */
+  Font GetFont(FontHandle h);
 
-#define STAGE_ATTRIBUTE(name) std::unordered_set<Actor *> _handle_##name;
-  STAGE_ATTRIBUTE(VISIBLE);
-#if __has_include("RayTheaterAttributes.hpp")
-#include "RayTheaterAttributes.hpp"
-#endif // __has_include("RayTheaterAttributes.hpp")
-#undef STAGE_ATTRIBUTE
+  /** @return number of resources, that are still loading */
+  unsigned int Pending();
 
-  void Play(Scene *sc);
+  /** @brief bytes that unused resources may occupy on the GPU, before they
+   * get unloaded (least recently used first) */
+  void Budget(size_t bytes);
 
-  void switchScene(Scene *);
-  void onResize();
+  /** @return bytes, the loaded resources occupy on the GPU */
+  size_t Usage();
 
-  template <typename T> void ClearActorFromStage(T *a);
-  void ClearStage();
+private:
+  ResourceCache(const ResourceCache &) = delete;
+  ResourceCache &operator=(const ResourceCache &) = delete;
+
+  enum SlotState { SLOT_FREE, SLOT_LOADING, SLOT_READY, SLOT_FAILED };
+
+  struct Slot {
+    std::string key;
+    unsigned int generation;
+    int refs;
+    SlotState state;
+    bool isFont;
+    Texture2D texture;
+    Font font;
+    size_t bytes;
+    unsigned long long lastUsed;
+  };
+
+  // A resource decoded by a worker, waiting to be uploaded to the GPU
+  struct Upload {
+    unsigned int slot;
+    unsigned int generation;
+    bool isFont;
+    std::string path;
+    int fontSize;
+    Image image;
+    GlyphInfo *glyphs;
+    Rectangle *recs;
+    int glyphCount;
+  };
+
+  // Shared with the workers, so it outlives jobs still running
+  struct Inbox {
+    std::mutex mutex;
+    std::deque<Upload> uploads;
+    ~Inbox();
+  };
+
+  std::shared_ptr<WorkerPool> _workers;
+  std::shared_ptr<Inbox> _inbox;
+  std::vector<Slot> _slots;
+  std::vector<unsigned int> _freeSlots;
+  std::unordered_map<std::string, unsigned int> _keys;
+  unsigned long long _useCounter;
+  unsigned int _pending;
+  size_t _budget;
+  size_t _usage;
+
+  Slot *slotOf(unsigned int slot, unsigned int generation);
+  unsigned int acquire(const std::string &key, bool isFont, bool *created);
+  void release(unsigned int slot, unsigned int generation);
+  void unloadSlot(unsigned int slot);
+  void evict();
+
+  static void decode(Upload &u);
+  static void freeUpload(Upload &u);
+
+  // Main thread only
+  void Update();
+  void Clear();
 };
 
-// BM: Builder - Class
+// BM: TweenEngine - Class
 //=============================================================================
-/**
- * @class Builder
- * @brief meant to provide an easy way to setup a Stage.
+enum Ease {
+  EASE_LINEAR,
+  EASE_IN_QUAD,
+  EASE_OUT_QUAD,
+  EASE_IN_OUT_QUAD,
+  EASE_IN_CUBIC,
+  EASE_OUT_CUBIC,
+  EASE_IN_OUT_CUBIC,
+  EASE_IN_SINE,
+  EASE_OUT_SINE,
+  EASE_IN_OUT_SINE,
+  EASE_OUT_BACK
+};
+
+/** @brief Identifies a running tween (0 = none) */
+typedef unsigned int TweenHandle;
+
+/** @brief Animates values over time. Each Scene on the Stage has its own
+ * (see Stage::Tweens). All tweens of a type are stored in one set of arrays
+ * and advanced together in a few tight loops per frame.
  */
-class Builder {
+class TweenEngine {
+public:
+  typedef std::function<void()> t_TweenDoneHandler;
+
+  TweenEngine();
+
+  /** @brief moves the value at target to the given value
+   * @param seconds - duration of the tween
+   * @param done - called, once the tween finished (not when cancelled)
+   */
+  TweenHandle To(float *target, float to, float seconds,
+                 Ease ease = EASE_LINEAR, t_TweenDoneHandler done = nullptr);
+  TweenHandle To(Vector2 *target, Vector2 to, float seconds,
+                 Ease ease = EASE_LINEAR, t_TweenDoneHandler done = nullptr);
+  TweenHandle To(Color *target, Color to, float seconds,
+                 Ease ease = EASE_LINEAR, t_TweenDoneHandler done = nullptr);
+
+  /** @brief moves the Actor to the given location (via setLoc) */
+  TweenHandle MoveTo(Transform2D *target, Vector2 to, float seconds,
+                     Ease ease = EASE_LINEAR,
+                     t_TweenDoneHandler done = nullptr);
+
+  /** @brief stops the tween, where it is
+   * @return false = the tween already finished */
+  bool Cancel(TweenHandle h);
+
+  /** @brief stops all tweens of the given target */
+  void CancelTarget(const void *target);
+
+  bool IsRunning(TweenHandle h);
+
+  /** @return number of running tweens */
+  unsigned int Count();
+
+  /** @return the eased progress, for t between 0 and 1 */
+  static float Apply(Ease ease, float t);
+
+private:
+  friend Stage;
+
+  // The tweens of one value type, one array per field
+  template <typename T, typename Target> struct Track {
+    std::vector<Target *> targets;
+    std::vector<T> from;
+    std::vector<T> to;
+    std::vector<float> time; // 0 = started, 1 = done
+    std::vector<float> rate; // 1 / duration
+    std::vector<float> eased;
+    std::vector<unsigned char> ease;
+    std::vector<TweenHandle> handles;
+    std::vector<t_TweenDoneHandler> done;
+
+    TweenHandle add(TweenHandle h, Target *target, T f, T t, float seconds,
+                    Ease e, t_TweenDoneHandler d);
+    void remove(size_t i);
+    bool cancel(TweenHandle h);
+    void cancelTarget(const void *target);
+    bool has(TweenHandle h);
+    void update(float dt, std::vector<t_TweenDoneHandler> &finished);
+  };
+
+  Track<float, float> _floats;
+  Track<Vector2, Vector2> _vectors;
+  Track<Color, Color> _colors;
+  Track<Vector2, Transform2D> _locs;
+  TweenHandle _nextHandle;
+
+  // Handlers of tweens, that finished this frame
+  std::vector<t_TweenDoneHandler> _finished;
+
+  void update(float dt);
+  TweenHandle nextHandle();
+
+  static float lerp(float f, float t, float e) { return f + (t - f) * e; }
+  static Vector2 lerp(Vector2 f, Vector2 t, float e) {
+    return {f.x + (t.x - f.x) * e, f.y + (t.y - f.y) * e};
+  }
+  static Color lerp(Color f, Color t, float e);
+  static unsigned char channel(unsigned char f, unsigned char t, float e);
+
+  static void apply(float *target, float v) { *target = v; }
+  static void apply(Vector2 *target, Vector2 v) { *target = v; }
+  static void apply(Color *target, Color v) { *target = v; }
+  static void apply(Transform2D *target, Vector2 v) { target->setLoc(v); }
+};
+
+// BM: FramePacer - Class
+//=============================================================================
+// Number of frames, the frame statistics are taken over
+#ifndef FRAME_STATS_SAMPLES
+#define FRAME_STATS_SAMPLES 1024
+#endif
+
+// Microseconds before the next frame, from which on the pacer spins instead
+// of sleeping (sleeping is not precise enough on most systems)
+#ifndef FRAME_SPIN_MICROSECONDS
+#define FRAME_SPIN_MICROSECONDS 2000
+#endif
+
+/** @brief Percentiles of a timing over the last FRAME_STATS_SAMPLES frames
+ * (in milliseconds) */
+struct FrameStats {
+  float p50 = 0;
+  float p95 = 0;
+  float p99 = 0;
+  float max = 0;
+  unsigned int samples = 0;
+};
+
+/** @brief Keeps the Stages frames at a steady rate and measures frame times
+ * and the latency from reading the input to presenting the frame.
+ */
+class FramePacer {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  FramePacer();
+
+  /** @brief frames per second to pace to (0 = don't wait at all) */
+  int fps;
+
+  /** @brief true = wait before reading the input, instead of after
+   * presenting the frame. The input is then as fresh as possible. */
+  bool lowLatency;
+
+  /** @brief resets the statistics and the frame clock */
+  void Start();
+
+  /** @brief waits until the next frame is due */
+  void Wait();
+
+  /** @brief to be called, once the input of the frame was read */
+  void InputSampled();
+
+  /** @brief to be called, once the frame was presented */
+  void FrameDone();
+
+  FrameStats FrameTimes() const;
+  FrameStats Latencies() const;
+
+private:
+  Clock::time_point _next;
+  Clock::time_point _lastFrame;
+  Clock::time_point _inputAt;
+
+  // Ring buffers of the last frames (milliseconds)
+  std::vector<float> _frameTimes;
+  std::vector<float> _latencies;
+  unsigned int _cursor;
+  unsigned int _count;
+
+  static FrameStats stats(const std::vector<float> &samples,
+                          unsigned int count);
+};
+
+// BM: FrameArena - Class
+//=============================================================================
+// Bytes, each of the Stages two FrameArenas starts with. An arena, that ran
+// out during a frame, grows to fit that frame from its next use on.
+#ifndef FRAME_ARENA_SIZE
+#define FRAME_ARENA_SIZE (256 * 1024)
+#endif
+
+/** @brief Scratch memory for a single frame (see Play::arena).
+ * Allocating only moves an offset forward, and nothing is freed on its own:
+ * Reset drops everything at once. The Stage keeps two arenas and switches
+ * between them at the start of each cycle, so memory taken in one frame is
+ * still valid during the next one.
+ *
+ * Nothing allocated here gets destructed, so only put trivially destructible
+ * values (or containers using an ArenaAllocator) into it. Not thread safe.
+ */
+class FrameArena {
+public:
+  FrameArena(size_t capacity = FRAME_ARENA_SIZE);
+
+  /** @return size bytes, aligned to align (a power of two) */
+  void *Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+  /** @return a T constructed from args (its destructor is never called) */
+  template <typename T, typename... Args> T *Make(Args &&...args);
+
+  /** @brief frees everything allocated at once (O(1), unless the arena ran
+   * out since the last Reset and is grown to one bigger block) */
+  void Reset();
+
+  /** @return bytes allocated since the last Reset */
+  size_t Used() const;
+
+  /** @return bytes, that fit in before the arena needs to grow */
+  size_t Capacity() const;
+
+private:
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  std::unique_ptr<char[]> _block;
+  size_t _capacity;
+  size_t _offset;
+
+  // Blocks added once _block ran out. Only the last one is allocated from.
+  std::vector<std::unique_ptr<char[]>> _overflow;
+  size_t _overflowSize;
+  size_t _overflowOffset;
+  size_t _used;
+
+  void *overflow(size_t size, size_t align);
+  static char *alignUp(char *p, size_t align);
+};
+
+/** @brief STL allocator, that takes its memory from a FrameArena. Containers
+ * using it must not outlive the frame after the one they were created in.
+ *
+ * @code
+ * FrameVector<Vector2> points(p.arena);
+ * @endcode
+ */
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  ArenaAllocator(FrameArena *arena) : arena(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) {}
+
+  FrameArena *arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+// BM: AllocationTracker - Class
+//=============================================================================
+/** @brief Parts of a Stage cycle, heap allocations are counted by */
+enum FramePhase {
+  PHASE_NONE,  // outside of a cycle (e.g. Scene switches, loading)
+  PHASE_SCENE, // Scene::OnUpdate, removing dead Actors
+  PHASE_INPUT, // reading and streaming the input
+  PHASE_TICK,  // ticking Actors and Tweens
+  PHASE_DRAW,  // sorting and drawing
+
+  __PHASE_COUNT
+};
+
+struct AllocationCounts {
+  unsigned long allocations = 0;
+  unsigned long frees = 0;
+  unsigned long bytes = 0;
+};
+
+/** @brief Counts the heap allocations of the thread playing the Stage, per
+ * FramePhase. Counting needs the global operator new / delete hooks of
+ * RayTheaterAllocations.hpp; without them all counts stay 0.
+ */
+class AllocationTracker {
+public:
+  static AllocationTracker &Get();
+
+  /** @return true, if the hooks of RayTheaterAllocations.hpp are linked in */
+  bool Hooked() const;
+
+  /** @return the counts of the last finished cycle (in one phase / in all
+   * phases) */
+  AllocationCounts LastFrame(FramePhase phase) const;
+  AllocationCounts LastFrame() const;
+
+  /** @return the counts since the program started */
+  AllocationCounts Total(FramePhase phase) const;
+
+  /** @return FrameArena bytes used by the last finished cycle */
+  size_t LastFrameArenaBytes() const;
+
+  static const char *PhaseName(FramePhase phase);
+
+  // Used by the Stage
+  //---------------------------------------------------------------------------
+  void TrackThisThread();
+  void BeginFrame();
+  void Phase(FramePhase phase);
+  void EndFrame(size_t arenaBytes);
+
+  // Used by the hooks
+  //---------------------------------------------------------------------------
+  void Hook();
+  void Allocated(size_t bytes);
+  void Freed();
+
+private:
+  AllocationTracker();
+
+  bool _hooked;
+  FramePhase _phase;
+  AllocationCounts _frame[__PHASE_COUNT];
+  AllocationCounts _last[__PHASE_COUNT];
+  AllocationCounts _total[__PHASE_COUNT];
+  size_t _lastArenaBytes;
+
+  // Allocations of other threads (e.g. the WorkerPool) are not counted
+  static bool &trackedThread();
+};
+
+// BM: Viewport - Class
+//=============================================================================
+/** @brief A view onto the Stage, with its own camera. Several Viewports
+ * draw the same Actors, e.g. for split-screen or a minimap.
+ */
+struct Viewport {
+  /** @brief the camera; its offset is relative to the rect */
+  Camera2D camera = {{0, 0}, {0, 0}, 0, 1};
+
+  /** @brief area of the Stage, the Viewport is drawn into */
+  Rectangle rect = {0, 0, 0, 0};
+
+  /** @brief Actors are only drawn, if they share a bit of their view
+   * layers with this mask (see Visible::SetViewLayers) */
+  unsigned int layerMask = ~0u;
+
+  bool active = true;
+};
+
+// BM: Stage - Class
+//=============================================================================
+class Stage {
+  friend class Builder;
+
 public:
+  ~Stage() { _scene = NULL; }
+
+  /** @brief Changes the Color of the Border, that is show, when the window is
+   * scaled to an aspect ratio different, than the Stages
+   */
+  void BorderColor(Color);
+
+  /** @brief Background-Color of the stage. (Each frame, the stage is cleared
+   * to this color.
+   */
+  void BackgroundColor(Color);
+
+  /** @brief Registers an Actor as being on the stage
+   *
+   * @param T any class that implement Theater::Actor
+   * @param a - reference that the Stage will use to adress the Actor
+   * @return a handle to the Actor (null, if it could not be added)
+   */
+  template <typename T> ActorHandle AddActor(T *a);
+
+  /** @brief Marks any Actor as "DEAD", meaning, it will be removed from the
+   * stage between cycles
+   *
+   * @param a the pointer to the actor to remove (Must be the same value as
+   * given in AddActor)
+   */
+  template <typename T> void RemoveActor(T *a);
+  void RemoveActor(ActorHandle);
+
+  /** @return the handle of an Actor of the current Scene (a null handle, if
+   * the Actor is not on the Stage) */
+  ActorHandle GetHandle(Actor *);
+
+  /** @return the Actor, the handle refers to, or NULL once that Actor left
+   * the Stage. O(1), no hashing. Actors of suspended Scenes resolve as well.
+   * The template version returns NULL, if the Actor is no T as well. */
+  Actor *GetActor(ActorHandle);
+  template <typename T> T *GetActor(ActorHandle);
+
+  /** @brief Pauses all Ticking Actors */
+  void Pause();
+
+  /** @brief Draws a render layer of the current Scene into its own texture,
+   * which is then drawn each frame instead of the layers Actors. The texture
+   * is only redrawn, when an Actor on the layer is made visible or
+   * invisible, changes its layer or is invalidated (Visible::Invalidate).
+   *
+   * @param layer - the render layer (see Visible::SetRenderLayer)
+   * @param cached - false = draw the layer directly again
+   */
+  void CacheRenderLayer(int layer, bool cached = true);
+
+  /** @brief Redraws a cached render layer with the next frame */
+  void InvalidateRenderLayer(int layer);
+
+  /** @return the tweens of the current Scene (see TweenEngine) */
+  TweenEngine &Tweens();
+
+  /** @return the current Scenes instance of T, created on first use. Lets
+   * additions keep state per Scene (e.g. UI::InputRouter); a pushed Scene
+   * gets its own instances.
+   *
+   * @tparam T a default constructible class
+   */
+  template <typename T> T &SceneState();
+
+  /** @return the locations of all Transform2D Actors of the current Scene.
+   * Only write to nextX and nextY, the Stage moves the Actors there at the
+   * start of the next cycle */
+  TransformStore &Transforms();
+
+  /** @brief Groups all Actors of type T, that are added to the Stage from now
+   * on. They are ticked together in one tight loop, instead of one by one.
+   * OnTick is called without the vtable, if the Stage may access it (public,
+   * or T declares Theater::Stage a friend).
+   *
+   * @tparam T a class that implements Theater::Actor and Theater::Ticking
+   */
+  template <typename T> void RegisterActorType();
+
+  /** @brief Starts the Scenes OnPreload on a background thread, ahead of
+   * a transition to it. In PlayHeadless, OnPreload runs right away instead,
+   * so each run takes the same number of cycles. (A replay switches in the
+   * recorded cycle, see InputStream::OnSceneSwitch) */
+  void Prefetch(Scene *);
+
+  /** @brief Routes the input of each cycle through the given InputStream
+   * (NULL = use the input as is)
+   */
+  void Input(InputStream *);
+
+  /** @return the Stages ResourceCache, for sharing Textures and Fonts, that
+   * are loaded in the background */
+  ResourceCache &Resources();
+
+  /** @return the Stages WorkerPool, for running jobs in the background */
+  WorkerPool &Workers();
+
+  /** @return true = playing headless (PlayHeadless). Results of background
+   * jobs must then not depend on when a worker finished, so each run plays
+   * out the same; run such jobs right away instead. */
+  bool IsHeadless();
+
+  /** @brief Paces the frames to the given rate (0 = don't pace) */
+  void TargetFPS(int fps);
+
+  /** @brief true = wait for the next frame before reading the input, instead
+   * of after presenting, so each frame reacts to the freshest input */
+  void LowLatency(bool on);
+
+  /** @return frame time percentiles (ms) over the last frames */
+  FrameStats FrameTimeStats();
+
+  /** @return percentiles of the time (ms) from reading the input to
+   * presenting the frame, over the last frames */
+  FrameStats LatencyStats();
+
+  /** @brief Test mode: from now on, each cycle, that allocates on the heap,
+   * is reported per FramePhase on std::cerr and aborts the program. Turn it
+   * on once the Scene reached a steady state. Needs RayTheaterAllocations.hpp
+   * (see AllocationTracker). Not checked are the cycles from a transition
+   * request up to the first full cycle of the next Scene. */
+  void AssertNoAllocations(bool on);
+
+  /** @brief Adds a view with its own camera. Once there is a Viewport, the
+   * Stage only draws its Actors through its Viewports.
+   * @return id of the Viewport
+   */
+  unsigned int AddViewport(Viewport vp);
+
+  /** @return the Viewport with the given id (NULL = no such Viewport) */
+  Viewport *GetViewport(unsigned int id);
+
+  /** @brief removes a Viewport; its id may be reused */
+  void RemoveViewport(unsigned int id);
+
+  /** @return the Stage location as seen through the Viewports camera in the
+   * world (e.g. for Play::mouseLoc) */
+  Vector2 ViewportToWorld(unsigned int id, Vector2 loc);
+
+  /**  @brief Continues to run all Ticking Actors */
+  void UnPause();
+
+  /** @brief By default Actors are invisible / Not rendered
+   * use this function to make it visible (Add it to the Stages render-list)
+   *
+   * @tparam T any class that implements Theater::Actor and Theater::Visible
+   * @return true on success ; false == to many Actors are already on stage or
+   * you called this function during rendering
+   */
+  template <typename T> bool MakeActorVisible(T *);
+  bool MakeActorVisible(ActorHandle);
+
+  /** @brief removes any visible Actor from the stages render-list
+   *
+   * @tparam T any class that implements Theater::Visible
+   */
+  template <typename T> void MakeActorInvisible(T *);
+  void MakeActorInvisible(ActorHandle);
+
   /**
-   * @brief
+   * @brief Allows for adding custom Attributes to an Actor on the Stage
    *
-   * @param width  - the stages with in pixels
-   * @param height - the stages height in pixels
-   * @param scale  - multiplier by which the window will be scaled (e.g. 2.0 =
-   * each pixel of the stage, takes 2 pixels in the Window)
+   * @return - true = attribute added; false = Actor not on stage or used
+   * illegal Attribute
    */
-  Builder(int width, int height, float scale = 1.0)
-      : _stage(Stage(width, height, scale)) {}
+  bool AddActorAttribute(Actor *, Attributes);
+  bool AddActorAttribute(ActorHandle, Attributes);
+
+  /**
+   * @brief Removes a custom Attribute from an Actor on the Stage
+   *
+   * @return - true = attribute removed; false = Actor not on stage or used
+   illegal
+   * Attribute
+
+   */
+  bool RemoveActorAttribute(Actor *, Attributes);
+  bool RemoveActorAttribute(ActorHandle, Attributes);
+
+  /**
+   * @brief gets an unordered_set of Actors all having the requested Attributes
+   *
+   * @param attr
+   */
+  std::unordered_set<Actor *> GetActorsWithAttribute(Attributes attr);
+
+  /**
+   * @brief Writes the state of all Actors on the Stage (Attributes,
+   * Transform2D locations, render layers and whatever the Actors write in
+   * OnSnapshotSave) into a flat binary buffer.
+   *
+   * @param buffer - will be replaced with the snapshot
+   */
+  void SaveSnapshot(std::vector<unsigned char> &buffer);
+
+  /**
+   * @brief Restores a snapshot taken with SaveSnapshot.
+   * The same Actors must be on the Stage (matched by their ActorHandle).
+   *
+   * @param data - the snapshot (e.g. a memory-mapped file)
+   * @param size - size of data in bytes
+   * @return true = restored; false = invalid snapshot or the Actors on the
+   * Stage don't match it (nothing is changed in that case)
+   */
+  bool LoadSnapshot(const unsigned char *data, size_t size);
+
+private:
+  // An Actor on the Stage, with its components already resolved
+  struct StageActor {
+    Actor *actor;
+    Ticking *ticking;
+    Transform2D *transform;
+    Visible *visible;
+    // Registered type the Actor ticks with (-1 = none) and its slot there
+    int tickGroup;
+    unsigned int tickSlot;
+    // Slot behind the Actors ActorHandle
+    unsigned int handleSlot;
+  };
+
+  // The slots behind ActorHandles. Shared by all Ensembles, so the handles
+  // of suspended Scenes can't be mistaken for those of the current one.
+  struct ActorSlot {
+    Actor *actor; // NULL = free
+    unsigned int generation;
+  };
+
+  // A render layer, that is drawn into its own texture
+  struct CachedLayer {
+    RenderTexture2D texture;
+    bool dirty;
+  };
+
+  // The Ticking components of all Actors of one registered type
+  struct TickGroup {
+    std::vector<Ticking *> tickers;
+    std::vector<Actor *> owners;
+  };
+
+  typedef void (Stage::*TickGroupFn)(unsigned int group);
+
+  // Everything a Scene put on the Stage. A suspended Scene keeps its
+  // Ensemble, while other Scenes play on top of it.
+  struct Ensemble {
+    Scene *scene;
+    std::vector<StageActor> actors;
+
+    RenderNode<Visible> renderNodes[ACTORLIMIT];
+    unsigned int renderNodeCnt;
+    RenderNode<Visible> renderNodeRoot;
+    std::unordered_map<int, CachedLayer> cachedLayers;
+
+    std::unordered_set<Ticking *> handle_TICKING;
+    std::vector<TickGroup> tickGroups;
+    TransformStore transforms;
+    TweenEngine tweens;
+    std::unordered_set<Actor *> handle_DEAD;
+
+    // Stage::SceneState instances, by a key per type
+    std::unordered_map<const void *, std::shared_ptr<void>> states;
+
+#define STAGE_ATTRIBUTE(name) std::unordered_set<Actor *> handle_##name;
+    STAGE_ATTRIBUTE(VISIBLE);
+#if __has_include("RayTheaterAttributes.hpp")
+#include "RayTheaterAttributes.hpp"
+#endif // __has_include("RayTheaterAttributes.hpp")
+#undef STAGE_ATTRIBUTE
+
+    Ensemble();
+  };
+
+  Stage(int width, int height, float scale = 1.0);
+
+  const char *_stageTitle;
+  float _stageWidth;
+  float _stageHeight;
+  float _stageScale;
+  RenderTexture2D _stage;
+  Scene *_scene;
+  Rectangle _viewportRect;
+  Rectangle _stageRect;
+  Vector2 _viewportOrigin;
+
+  Color _borderColor;
+  Color _backgroundColor;
+
+  Theater::Play _play;
+
+  // Viewports, and the render list flattened once per frame, so each
+  // Viewport only culls one array instead of walking the list again
+  struct DrawItem {
+    Visible *obj; // NULL = a cached render layer
+    int layer;
+    unsigned int viewLayers;
+    Rectangle bounds;
+  };
+  std::vector<Viewport> _viewports;
+  unsigned int _viewportCnt;
+  std::vector<DrawItem> _drawList;
+
+  bool _rendering;
+  bool _sceneUnloading;
+  bool _tickingPaused;
+  bool _headless;
+  bool _assertNoAllocations;
+  bool _trackAllocations;
+  bool _sceneSettling; // Scene switch pending, or the next one warming up
+
+  InputStream *_input;
+  FramePacer _pacer;
+
+  // Shared, since the Builder hands out copies of the Stage
+  std::shared_ptr<WorkerPool> _workers;
+  std::shared_ptr<ResourceCache> _resources;
+
+  // Scratch memory of this frame and of the last one (see Play::arena)
+  std::shared_ptr<FrameArena> _arena;
+  std::shared_ptr<FrameArena> _lastArena;
+
+  // The Ensemble of the current Scene, and those of the suspended Scenes
+  // below it (last = directly below)
+  std::shared_ptr<Ensemble> _ensemble;
+  std::vector<std::shared_ptr<Ensemble>> _suspended;
+
+  std::vector<ActorSlot> _actorSlots;
+  std::vector<unsigned int> _freeActorSlots;
+
+  // Registered Actor types and the loops ticking them
+  std::unordered_map<std::type_index, unsigned int> _tickGroupIds;
+  std::vector<TickGroupFn> _tickGroupFns;
+
+  void Play(Scene *sc);
+  void PlayHeadless(Scene *sc, unsigned long cycles, float deltaTime);
+
+  void preparePlay();
+  bool startCycle();
+  void endCycle();
+  void allocationPhase(FramePhase phase);
+  void pollInput(unsigned char pressed = 0);
+  bool streamInput();
+  void tickActors();
+  void sortRenderNodes();
+  void drawCycle();
+  void drawCachedLayers();
+  void drawViewports();
+  void buildDrawList();
+
+  void switchScene(Scene *);
+  void pushScene(Scene *);
+  void endPlay();
+  void onResize();
+
+  bool isOnStage(Actor *a);
+  StageActor *stageActor(ActorHandle h);
+  unsigned int takeActorSlot(Actor *a);
+  void releaseActorSlot(unsigned int slot);
+  void ClearActorFromStage(Actor *a);
+  void ClearStage();
+
+  bool showActor(Actor *, Visible *);
+  void hideActor(Actor *, Visible *);
+
+  template <typename T> void tickGroup(unsigned int group);
+
+  // Calls T::OnTick directly, so it can be inlined, if the Stage may access
+  // it (public, or T is a friend of Stage). Through the vtable otherwise.
+  template <typename T>
+  static auto tickOne(T *t, const Theater::Play &p, int)
+      -> decltype(t->T::OnTick(p), void());
+  template <typename T>
+  static void tickOne(T *t, const Theater::Play &p, long);
+  void joinTickGroup(StageActor &sa);
+  void leaveTickGroup(StageActor &sa);
+
+  // Transforms, whose world values are recomputed this cycle
+  std::vector<Transform2D *> _transformQueue;
+
+  void joinTransforms(Transform2D *t);
+  void leaveTransforms(Transform2D *t);
+  void flipTransforms();
+  void updateWorldTransforms(size_t first);
+};
+
+// BM: Builder - Class
+//=============================================================================
+/**
+ * @class Builder
+ * @brief meant to provide an easy way to setup a Stage.
+ */
+class Builder {
+public:
+  /**
+   * @brief
+   *
+   * @param width  - the stages with in pixels
+   * @param height - the stages height in pixels
+   * @param scale  - multiplier by which the window will be scaled (e.g. 2.0 =
+   * each pixel of the stage, takes 2 pixels in the Window)
+   */
+  Builder(int width, int height, float scale = 1.0)
+      : _stage(Stage(width, height, scale)) {}
+
+  /**
+   * @brief Sets the Title for the opened Window
+   *
+   * @param t - title
+   * @return  itself, for easy chaining of setters
+   */
+  Builder Title(const char *t) {
+    _stage._stageTitle = t;
+    return *this;
+  }
+
+  /**
+   * @brief changes the color fo the border, that is shown, when
+   * the window is scaled to a different aspect ratio
+   *
+   * @param c  - Raylib Color
+   * @return  itself for easy chaining of setters
+   */
+  Builder BorderColor(Color c) {
+    _stage._borderColor = c;
+    return *this;
+  }
+
+  /**
+   * @brief sets the cleard background-color of the Stage
+   *
+   * @param c - Raylib Color
+   * @return  itself for easy chainging of setters
+   */
+  Builder BackgroundColor(Color c) {
+    _stage._backgroundColor = c;
+    return *this;
+  }
+
+  /**
+   * @brief routes the input of each cycle through the given InputStream
+   * (e.g. to record or replay it)
+   *
+   * @param i - the InputStream (NULL = use the input as is)
+   * @return  itself for easy chainging of setters
+   */
+  Builder Input(InputStream *i) {
+    _stage._input = i;
+    return *this;
+  }
+
+  /**
+   * @brief paces the frames to a steady rate
+   *
+   * @param fps - frames per second (0 = don't pace)
+   * @param lowLatency - true = wait before reading the input, instead of
+   * after presenting the frame
+   * @return  itself for easy chainging of setters
+   */
+  Builder TargetFPS(int fps, bool lowLatency = false) {
+    _stage._pacer.fps = fps;
+    _stage._pacer.lowLatency = lowLatency;
+    return *this;
+  }
+
+  /**
+   * @brief Opens the window and starts playing the given Scene
+   * @param sc
+   */
+  void Play(Scene *sc) { _stage.Play(sc); }
+
+  /**
+   * @brief Plays the given Scene without opening a window.
+   * Nothing is drawn and no input is read. Each cycle advances the Stage
+   * by the fixed `deltaTime`, as fast as the CPU allows.
+   * Meant for benchmarks, tests and simulations.
+   *
+   * @param sc - the Scene to play
+   * @param cycles - number of cycles to run (0 = until the Scene
+   * transitions to NULL)
+   * @param deltaTime - the Play::deltaTime given to each cycle
+   */
+  void PlayHeadless(Scene *sc, unsigned long cycles = 0,
+                    float deltaTime = 1.0f / 60.0f) {
+    _stage.PlayHeadless(sc, cycles, deltaTime);
+  }
+
+private:
+  Stage _stage;
+};
+
+// BM: Stage - Implementation
+//==============================================================================
+inline Stage::Stage(int width, int height, float scale)
+    : _scene(0x0), _viewportOrigin({0, 0}),
+      _stageRect(
+          {0, 0, static_cast<float>(width), static_cast<float>(-height)}),
+      _viewportRect({0, 0, static_cast<float>(width) * scale,
+                     static_cast<float>(height) * scale}),
+      _stageWidth(width), _stageHeight(height), _play(),
+      _backgroundColor(Color{0x00, 0x00, 0xAA, 0xff}),
+      _borderColor(Color{0x00, 0x88, 0xff, 0xff}), _stageScale(scale),
+      _stageTitle("< RayWrapC - Project >"), _rendering(false),
+      _sceneUnloading(false), _tickingPaused(false),
+      _assertNoAllocations(false), _trackAllocations(false),
+      _sceneSettling(false),
+      _headless(false), _input(NULL),
+      _workers(new WorkerPool()), _resources(new ResourceCache(_workers)),
+      _arena(new FrameArena()), _lastArena(new FrameArena()),
+      _ensemble(new Ensemble()), _suspended(), _tickGroupIds(),
+      _tickGroupFns(), _viewports(), _viewportCnt(0), _drawList() {
+
+  static_assert(ACTORLIMIT > 0, "Set ACTORLIMIT must be bigger than 0");
+}
+
+inline Stage::Ensemble::Ensemble()
+    : scene(NULL), actors(), renderNodes(), renderNodeCnt(0), cachedLayers(),
+      handle_TICKING(), tickGroups(), transforms(), tweens(), handle_DEAD(),
+      states() {
+  renderNodeRoot.next = NULL;
+  renderNodeRoot.prev = NULL;
+  renderNodeRoot.obj = NULL;
+  renderNodeRoot.alive = false;
+  renderNodeRoot.index = INT_MIN;
+}
+
+// BM: Stage - Implementation - Play
+//------------------------------------------------------------------------------
+inline void Stage::Play(Scene *sc) {
+  _headless = false;
+
+  // Setup the Window
+  SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+  InitWindow(_viewportRect.width, _viewportRect.height, _stageTitle);
+  if (!IsWindowReady()) {
+    throw "window not ready";
+  }
+
+  // Setup the Render-Area / Stage-Texture
+  _stage = LoadRenderTexture(_stageWidth, _stageHeight);
+  if (!IsRenderTextureReady(_stage)) {
+    CloseWindow();
+    throw "failed to create render texture";
+  }
+
+  // Prepare the _play - context
+  preparePlay();
+
+  // Activate the given scene
+  switchScene(sc);
+
+  // Start the main-Loop
+  while (!WindowShouldClose() && _scene != NULL) {
+
+    if (!startCycle())
+      continue;
+
+    // React to Window being resized
+    if (IsWindowResized())
+      onResize();
+
+    // Put DeltaTime - Multiplyer into context
+    _play.deltaTime = GetFrameTime();
+
+    // Move resources, that finished loading, onto the GPU
+    _resources->Update();
+
+    // In low latency mode, wait first and then read the input anew.
+    // Presses seen by the last read would get lost with the new one.
+    allocationPhase(PHASE_INPUT);
+    unsigned char pressed = 0;
+    if (_pacer.lowLatency) {
+      for (unsigned char a = 1; a < 7; a++)
+        pressed |= (IsMouseButtonPressed(a - 1) ? 1 : 0) << a;
+
+      _pacer.Wait();
+      PollInputEvents();
+    }
+
+    pollInput(pressed);
+    _pacer.InputSampled();
+    if (!streamInput())
+      break;
+
+    tickActors();
+    sortRenderNodes();
+    drawCycle();
+    endCycle();
+
+    if (!_pacer.lowLatency)
+      _pacer.Wait();
+  }
+
+  endPlay();
+  if (_input != NULL)
+    _input->OnPlayEnd(_play);
+  _resources->Clear();
+  UnloadRenderTexture(_stage);
+}
+
+// BM: Stage - Implementation - PlayHeadless
+//------------------------------------------------------------------------------
+inline void Stage::PlayHeadless(Scene *sc, unsigned long cycles,
+                                float deltaTime) {
+  _headless = true;
+  preparePlay();
+  switchScene(sc);
+
+  unsigned long cycle = 0;
+  while (_scene != NULL && (cycles == 0 || cycle < cycles)) {
+
+    if (!startCycle())
+      continue;
+
+    // Without a window, there is no input and time passes at a fixed rate
+    allocationPhase(PHASE_INPUT);
+    _play.deltaTime = deltaTime;
+    _pacer.InputSampled();
+    if (!streamInput())
+      break;
+
+    tickActors();
+    sortRenderNodes();
+    endCycle();
+    cycle++;
+  }
+
+  endPlay();
+  if (_input != NULL)
+    _input->OnPlayEnd(_play);
+}
+
+// BM: Stage - Implementation - Cycle
+//------------------------------------------------------------------------------
+inline void Stage::preparePlay() {
+  _pacer.Start();
+  // Without the hooks, there is nothing to count
+  _trackAllocations = AllocationTracker::Get().Hooked();
+  if (_trackAllocations)
+    AllocationTracker::Get().TrackThisThread();
+  _play.stage = this;
+  _play.arena = _arena.get();
+  _play.stageWidth = _stageWidth;
+  _play.stageHeight = _stageHeight;
+
+  if (_input != NULL)
+    _input->OnPlayStart(_play);
+}
+
+inline bool Stage::startCycle() {
+  AllocationTracker::Get().BeginFrame();
+
+  // The arena of the frame before the last one is free again
+  std::swap(_arena, _lastArena);
+  _arena->Reset();
+  _play.arena = _arena.get();
+
+  // Tick the Scene with the state crated by the last frame.
+  if (!_scene->Tick(_play)) {
+    _sceneSettling = true;
+    Scene *next = _scene->followup();
+
+    // Headless, this preloads right here, so the switch below happens in
+    // the cycle, that requested it
+    if (next != NULL && !next->IsPreloaded())
+      Prefetch(next);
+
+    // If the scene should end, attempt a scene Switch instead of
+    // continuing. The current Scenes Actors keep playing, until the next
+    // one is preloaded, or the InputStream (a replay) says so.
+    bool ready = next == NULL || next->IsPreloaded();
+    if (next != NULL && _input != NULL)
+      ready = _input->OnSceneSwitch(_play, ready);
+
+    if (ready) {
+      if (_scene->_pushRequested)
+        pushScene(next);
+      else
+        switchScene(NULL);
+      return false;
+    }
+  }
+
+  // Remove all Actors, that have been killed in the last cycle.
+  if (!_ensemble->handle_DEAD.empty()) {
+    std::unordered_set<Actor *> dead;
+    dead.swap(_ensemble->handle_DEAD);
+    for (auto act : dead)
+      ClearActorFromStage(act);
+  }
+
+  // Flip all the Actors State
+  flipTransforms();
+
+  return true;
+}
+
+inline void Stage::allocationPhase(FramePhase phase) {
+  if (_trackAllocations)
+    AllocationTracker::Get().Phase(phase);
+}
+
+inline void Stage::endCycle() {
+  _pacer.FrameDone();
+
+  AllocationTracker &tracker = AllocationTracker::Get();
+  tracker.EndFrame(_arena->Used());
+
+  // Preloading, switching and the first cycle of the next Scene may allocate
+  bool settling = _sceneSettling;
+  _sceneSettling = false;
+  if (!_assertNoAllocations || settling ||
+      tracker.LastFrame().allocations == 0)
+    return;
+
+  std::cerr << "AssertNoAllocations: a steady state cycle allocated";
+  for (int a = 0; a < __PHASE_COUNT; a++) {
+    AllocationCounts c = tracker.LastFrame((FramePhase)a);
+    if (c.allocations > 0)
+      std::cerr << " | " << AllocationTracker::PhaseName((FramePhase)a)
+                << ": " << c.allocations << "x (" << c.bytes << " bytes)";
+  }
+  std::cerr << std::endl;
+  std::abort();
+}
+
+inline void Stage::pollInput(unsigned char pressed) {
+  // Update MousePosition
+  _play.mouseLoc = Vector2({(float)GetMouseX(), (float)GetMouseY()});
+
+  _play.mouseLoc.x -= _viewportRect.x;
+  _play.mouseLoc.y -= _viewportRect.y;
+
+  _play.mouseLoc.x /= _stageScale;
+  _play.mouseLoc.y /= _stageScale;
+
+  _play.mouseX = std::floor(_play.mouseLoc.x);
+  _play.mouseY = std::floor(_play.mouseLoc.y);
+
+  // Update MouseButtons
+  _play.mouseReleased = _play.mouseHeld | _play.mouseDown;
+  _play.mouseHeld = 0;
+  _play.mouseUp = 0;
+  _play.mouseDown = 0;
+
+  for (unsigned char a = 1; a < 7; a++) {
+    _play.mouseDown |= (IsMouseButtonPressed(a - 1) ? 1 : 0) << a;
+    _play.mouseHeld |= (IsMouseButtonDown(a - 1) ? 1 : 0) << a;
+    _play.mouseUp |= (IsMouseButtonUp(a - 1) ? 1 : 0) << a;
+  }
+
+  // Presses, that were read before the input was polled again
+  _play.mouseDown |= pressed;
+
+  // Just in case held and Pressed overlap => remove Pressed from held.
+  _play.mouseHeld &= ~_play.mouseDown;
+  _play.mouseUp &= ~(_play.mouseDown | _play.mouseHeld);
+  _play.mouseReleased &= _play.mouseUp;
+}
+
+inline bool Stage::streamInput() {
+  if (_input == NULL)
+    return true;
+
+  return _input->OnInput(_play);
+}
+
+inline void Stage::tickActors() {
+  allocationPhase(PHASE_TICK);
+  if (_tickingPaused)
+    return;
+
+  _ensemble->tweens.update(_play.deltaTime);
+
+  // Registered types first, one loop per type
+  for (unsigned int g = 0; g < _ensemble->tickGroups.size(); g++)
+    (this->*_tickGroupFns[g])(g);
+
+  for (Ticking *ticker : _ensemble->handle_TICKING)
+    ticker->OnTick(_play);
+}
+
+template <typename T> inline void Stage::tickGroup(unsigned int group) {
+  // Actors added during the loop may grow the group, or add new groups and
+  // move all of them, so look the group up anew for each step
+  for (size_t a = 0; a < _ensemble->tickGroups[group].tickers.size(); a++)
+    tickOne(static_cast<T *>(_ensemble->tickGroups[group].tickers[a]), _play,
+            0);
+}
+
+// A group only holds Actors of exactly the type T, so the qualified call
+// can't skip an override
+template <typename T>
+inline auto Stage::tickOne(T *t, const Theater::Play &p, int)
+    -> decltype(t->T::OnTick(p), void()) {
+  t->T::OnTick(p);
+}
+
+template <typename T>
+inline void Stage::tickOne(T *t, const Theater::Play &p, long) {
+  static_cast<Ticking *>(t)->OnTick(p);
+}
+
+inline void Stage::sortRenderNodes() {
+  allocationPhase(PHASE_DRAW);
+
+  // Figure out the Render order of actors;
+  int rnCnt = _ensemble->renderNodeCnt;
+  RenderNode<Visible> *rn = &_ensemble->renderNodeRoot;
+  rn->next = NULL;
+  bool caching = !_ensemble->cachedLayers.empty();
+  for (int a = 0; a < rnCnt; a++) {
+    auto node = &(_ensemble->renderNodes[a]);
+
+    // Redraw cached layers, whose Actors changed
+    if (caching &&
+        (node->obj->_invalidated || node->index != node->obj->_zindex)) {
+      InvalidateRenderLayer(node->index);
+      InvalidateRenderLayer(node->obj->_zindex);
+    }
+    node->obj->_invalidated = false;
+
+    node->index = node->obj->_zindex;
+
+    if (node->alive == false)
+      continue;
+
+    if (node->index >= rn->index) {
+      while (rn->next != NULL && rn->next->index <= node->index)
+        rn = rn->next;
+
+      node->next = NULL;
+      if (rn->next != NULL) {
+        rn->next->prev = node;
+        node->next = rn->next;
+      }
+
+      rn->next = node;
+      node->prev = rn;
+
+    } else if (node->index < rn->index) {
+      while (rn->prev != NULL && rn->prev->index > node->index)
+        rn = rn->prev;
+
+      rn->prev->next = node;
+      node->prev = rn->prev;
+      node->next = rn;
+      rn->prev = node;
+    }
+
+    rn = node;
+  }
+}
+
+inline void Stage::drawCycle() {
+  _rendering = true;
+
+  // Texture modes can't be nested, so the cached layers are done first
+  bool caching = !_ensemble->cachedLayers.empty();
+  if (caching)
+    drawCachedLayers();
+
+  // Start drawing on the Stage
+  BeginTextureMode(_stage);
+  ClearBackground(_backgroundColor);
+
+  RenderNode<Visible> *rn = _ensemble->renderNodeRoot.next;
+  if (_viewportCnt > 0) {
+    drawViewports();
+    rn = NULL;
+  }
+
+  while (rn != NULL) {
+    auto cached = caching ? _ensemble->cachedLayers.find(rn->index)
+                          : _ensemble->cachedLayers.end();
+    if (cached == _ensemble->cachedLayers.end()) {
+      rn->obj->OnDraw(_play);
+      rn = rn->next;
+      continue;
+    }
+
+    // One blit for the whole layer, then skip its Actors
+    DrawTextureRec(cached->second.texture.texture,
+                   {0, 0, _stageWidth, -_stageHeight}, {0, 0}, WHITE);
+    int layer = rn->index;
+    while (rn != NULL && rn->index == layer)
+      rn = rn->next;
+  }
+
+  _scene->OnStageDraw(_play);
+  EndTextureMode();
+
+  // Start drawing on the Stage
+  BeginDrawing();
+  ClearBackground(_borderColor);
+  DrawTexturePro(_stage.texture, _stageRect, _viewportRect, _viewportOrigin,
+                 0, WHITE);
+  _scene->OnWindowDraw(_play);
+  EndDrawing();
+
+  _rendering = false;
+}
+
+inline void Stage::drawCachedLayers() {
+  bool dirty = false;
+  for (auto &cl : _ensemble->cachedLayers) {
+    if (cl.second.texture.id == 0) {
+      cl.second.texture = LoadRenderTexture(_stageWidth, _stageHeight);
+      cl.second.dirty = true;
+    }
+    dirty |= cl.second.dirty;
+  }
+
+  if (!dirty)
+    return;
+
+  // The render list is sorted, so each layer is one run of nodes
+  RenderNode<Visible> *rn = _ensemble->renderNodeRoot.next;
+  while (rn != NULL) {
+    int layer = rn->index;
+    auto cached = _ensemble->cachedLayers.find(layer);
+
+    if (cached == _ensemble->cachedLayers.end() || !cached->second.dirty) {
+      while (rn != NULL && rn->index == layer)
+        rn = rn->next;
+      continue;
+    }
+
+    BeginTextureMode(cached->second.texture);
+    ClearBackground(BLANK);
+    while (rn != NULL && rn->index == layer) {
+      rn->obj->OnDraw(_play);
+      rn = rn->next;
+    }
+    EndTextureMode();
+    cached->second.dirty = false;
+  }
+
+  // Layers, that have no Actors left
+  for (auto &cl : _ensemble->cachedLayers)
+    if (cl.second.dirty) {
+      BeginTextureMode(cl.second.texture);
+      ClearBackground(BLANK);
+      EndTextureMode();
+      cl.second.dirty = false;
+    }
+}
+
+inline void Stage::CacheRenderLayer(int layer, bool cached) {
+  auto found = _ensemble->cachedLayers.find(layer);
+
+  if (cached && found == _ensemble->cachedLayers.end()) {
+    CachedLayer cl = {};
+    cl.dirty = true;
+    _ensemble->cachedLayers[layer] = cl;
+
+  } else if (!cached && found != _ensemble->cachedLayers.end()) {
+    if (found->second.texture.id != 0)
+      UnloadRenderTexture(found->second.texture);
+    _ensemble->cachedLayers.erase(found);
+  }
+}
+
+inline void Stage::InvalidateRenderLayer(int layer) {
+  auto found = _ensemble->cachedLayers.find(layer);
+  if (found != _ensemble->cachedLayers.end())
+    found->second.dirty = true;
+}
+
+inline void Stage::Pause() { _tickingPaused = true; }
+inline void Stage::UnPause() { _tickingPaused = false; }
+inline void Stage::Prefetch(Scene *sc) {
+  if (sc == NULL || !sc->beginPreload())
+    return;
+
+  // Waiting for a worker would make the number of cycles depend on thread
+  // timing, which breaks replays
+  if (_headless) {
+    sc->runPreload();
+    return;
+  }
+
+  _workers->Run([sc]() { sc->runPreload(); });
+}
+
+inline void Stage::Input(InputStream *i) { _input = i; }
+inline ResourceCache &Stage::Resources() { return *_resources; }
+inline WorkerPool &Stage::Workers() { return *_workers; }
+inline bool Stage::IsHeadless() { return _headless; }
+inline void Stage::TargetFPS(int fps) { _pacer.fps = fps; }
+inline void Stage::LowLatency(bool on) { _pacer.lowLatency = on; }
+inline FrameStats Stage::FrameTimeStats() { return _pacer.FrameTimes(); }
+inline FrameStats Stage::LatencyStats() { return _pacer.Latencies(); }
+
+inline void Stage::AssertNoAllocations(bool on) {
+  if (on && !AllocationTracker::Get().Hooked()) {
+    std::cerr << "AssertNoAllocations: the allocation hooks are not linked "
+                 "in (include RayTheaterAllocations.hpp)"
+              << std::endl;
+    return;
+  }
+  _assertNoAllocations = on;
+}
+
+inline void Stage::switchScene(Scene *sc) {
+  _sceneUnloading = true;
+
+  if (_scene != NULL) {
+
+    if (sc == NULL)
+      sc = _scene->Unload(_play);
+    else
+      _scene->Unload(_play);
+
+    _scene = NULL;
+
+    // A pushed Scene ended, return to the one below
+    if (sc == NULL && !_suspended.empty()) {
+      ClearStage();
+      _ensemble = _suspended.back();
+      _suspended.pop_back();
+
+      _scene = _ensemble->scene;
+      _sceneUnloading = false;
+      _scene->OnResume(_play);
+      return;
+    }
+  }
+
+  if (sc != NULL) {
+    // A Scene started without a transition (e.g. the first one) is
+    // preloaded right here
+    if (sc->beginPreload())
+      sc->runPreload();
+
+    while (!sc->IsPreloaded())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    sc->OnStart(_play);
+    _scene = sc;
+    _ensemble->scene = sc;
+  }
+
+  _sceneUnloading = false;
+}
+
+inline void Stage::pushScene(Scene *sc) {
+  _scene->_transitionRequested = false;
+  _scene->_pushRequested = false;
+  _scene->OnSuspend(_play);
+
+  // Set the current Ensemble aside, as is
+  _suspended.push_back(_ensemble);
+  _ensemble = std::make_shared<Ensemble>();
+  _scene = NULL;
+
+  switchScene(sc);
+}
+
+inline void Stage::endPlay() {
+  _sceneUnloading = true;
+
+  // End the current Scene and all suspended ones below it
+  while (true) {
+    if (_scene != NULL)
+      _scene->Unload(_play);
+    _scene = NULL;
+
+    ClearStage();
+    if (_suspended.empty())
+      break;
+
+    _ensemble = _suspended.back();
+    _suspended.pop_back();
+    _scene = _ensemble->scene;
+  }
+
+  _sceneUnloading = false;
+}
+
+inline void Stage::BorderColor(Color c) { _borderColor = c; }
+
+inline void Stage::BackgroundColor(Color c) { _backgroundColor = c; }
+
+inline void Stage::onResize() {
+  float screenWidth = GetScreenWidth();
+  float screenHeight = GetScreenHeight();
+  float scale =
+      ::std::min(screenWidth / _stageWidth, screenHeight / _stageHeight);
+
+  _stageScale = scale;
+  _viewportRect.width = _stageWidth * scale;
+  _viewportRect.height = _stageHeight * scale;
+  _viewportRect.x = (screenWidth - _viewportRect.width) * 0.5;
+  _viewportRect.y = (screenHeight - _viewportRect.height) * 0.5;
+
+  // OnStageResize may add or remove Actors, so work through a copy
+  std::vector<StageActor> actors(_ensemble->actors);
+  for (StageActor &sa : actors)
+    if (isOnStage(sa.actor))
+      sa.actor->OnStageResize(_play);
+}
+
+template <typename T> inline ActorHandle Stage::AddActor(T *a) {
+  static_assert(std::is_base_of<Actor, T>::value,
+                "Can't add class, that does not inherit from Theater::Actor");
+
+  if (isOnStage(a))
+    return GetHandle(a);
+
+  if (((Actor *)a)->_stageIndex != -1) {
+    std::cout << "Can't add an Actor, that belongs to a suspended Scene"
+              << std::endl;
+    return ActorHandle();
+  }
+
+  StageActor sa = {a,
+                   actorComponent<Ticking>(a),
+                   actorComponent<Transform2D>(a),
+                   actorComponent<Visible>(a),
+                   -1,
+                   0,
+                   takeActorSlot(a)};
+  ActorHandle handle(sa.handleSlot, _actorSlots[sa.handleSlot].generation);
+
+  ((Actor *)a)->_stageIndex = _ensemble->actors.size();
+
+  if (sa.ticking != NULL)
+    joinTickGroup(sa);
+
+  _ensemble->actors.push_back(sa);
+
+  if (sa.transform != NULL)
+    joinTransforms(sa.transform);
+
+  ((Actor *)a)->OnStageEnter(_play);
+  return handle;
+}
+
+/** @brief Will remove an Actor from the stage, on the start of the next Cycle
+ *
+ * @param a - the actor to remove
+ */
+template <typename T> inline void Stage::RemoveActor(T *a) {
+  static_assert(std::is_base_of<Actor, T>::value,
+                "Cant call RemoveActor with none Actors");
+
+  if (_sceneUnloading)
+    ClearActorFromStage(a);
+  else {
+    a->_attributes.insert(DEAD);
+    _ensemble->handle_DEAD.insert(a);
+  }
+}
+
+/** @brief Activates the Rendinger of the actor on the stage
+ *
+ * Can only execute, when not rendering.
+ *
+ * @tparam T  - Any Class extending Theater::Actor and Theater::Visible
+ * @param actor - an instance of the A Class extending Theater::Actor and
+ * Theater::Visible
+ * @return true = Actor is now visible ; false = limit of visible actors
+ * reached or you tried to change an actors visibility during rendering.
+ */
+template <typename T> inline bool Stage::MakeActorVisible(T *actor) {
+  if (this->_rendering)
+    return false;
+
+  // Make sure the given Object supports the right classes
+  static_assert(
+      std::is_base_of<Actor, T>::value,
+      "Can't make a class visible, that does not implement Theater::Actor");
+
+  static_assert(
+      std::is_base_of<Visible, T>::value,
+      "Can't make a class visible, that does not implement Theater::Visible");
+
+  return showActor((Actor *)actor, (Visible *)actor);
+}
+
+template <typename T> inline void Stage::MakeActorInvisible(T *actor) {
+  if (this->_rendering)
+    return;
+
+  // make sure the given Object has the right Classes
+  static_assert(
+      std::is_base_of<Visible, T>::value,
+      "Can't make a class visible, that does not implement Theater::Visible");
+
+  hideActor(actorComponent<Actor>(actor), (Visible *)actor);
+}
+
+inline bool Stage::showActor(Actor *act, Visible *vis) {
+  if (this->_rendering)
+    return false;
+
+  // Already visible, nothing to do
+  if (vis->_renderListIndex != -1)
+    return true;
+
+  // Should there be no free slots anymore, do nothing and fail
+  if (_ensemble->renderNodeCnt == ACTORLIMIT)
+    return false;
+
+  // Otherwise set the splot tho the new object
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].obj = vis;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].alive = true;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].next = NULL;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].prev = NULL;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].index = vis->_zindex;
+  vis->_renderListIndex = _ensemble->renderNodeCnt;
+  _ensemble->renderNodeCnt++;
+  InvalidateRenderLayer(vis->_zindex);
+
+  // Give the Actor the "Visible" Attribute
+  act->_attributes.insert(VISIBLE);
+
+  // Return successfully
+  return true;
+}
+
+inline void Stage::hideActor(Actor *act, Visible *vis) {
+  if (this->_rendering)
+    return;
+
+  // If there is no Objects to remove, do nothing
+  if (_ensemble->renderNodeCnt == 0)
+    return;
+
+  if (act != NULL) {
+    act->_attributes.erase(VISIBLE);
+  }
+
+  // if the objects _renderListIndex is -1 -> do nothing
+  if (vis->_renderListIndex == -1)
+    return;
+
+  InvalidateRenderLayer(_ensemble->renderNodes[vis->_renderListIndex].index);
+
+  _ensemble->renderNodeCnt--;
+  // If the removed element is not the last one.
+  if ((unsigned int)vis->_renderListIndex != _ensemble->renderNodeCnt) {
+    // Move the last elements content to the slot of the element to remove
+    _ensemble->renderNodes[vis->_renderListIndex].obj =
+        _ensemble->renderNodes[_ensemble->renderNodeCnt].obj;
+
+    _ensemble->renderNodes[vis->_renderListIndex].index =
+        _ensemble->renderNodes[_ensemble->renderNodeCnt].index;
+    _ensemble->renderNodes[vis->_renderListIndex].alive =
+        _ensemble->renderNodes[_ensemble->renderNodeCnt].alive;
+    _ensemble->renderNodes[vis->_renderListIndex].next =
+        _ensemble->renderNodes[_ensemble->renderNodeCnt].next;
+    _ensemble->renderNodes[vis->_renderListIndex].prev =
+        _ensemble->renderNodes[_ensemble->renderNodeCnt].prev;
+
+    _ensemble->renderNodes[vis->_renderListIndex].obj->_renderListIndex =
+        vis->_renderListIndex;
+  }
+
+  // Then remove the last Slot
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].obj = NULL;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].alive = false;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].next = NULL;
+  _ensemble->renderNodes[_ensemble->renderNodeCnt].prev = NULL;
+  vis->_renderListIndex = -1;
+}
+
+inline bool Stage::AddActorAttribute(Actor *act, Attributes attr) {
+  if (!isOnStage(act)) {
+    return false;
+  }
+
+  switch (attr) {
+  case DEAD:
+    std::cout << " Can't assign ActorAttribute 'DEAD' via "
+                 "Stage::AddActorAttribute => use Stage::RemoveActor instead"
+              << std::endl;
+    return false;
+
+  case TICKING:
+    std::cout
+        << " Can't assign Internal Attribute 'TICKING' via AddActorAttribute "
+           "The Actors class must instead inherit from Theater::Ticking"
+        << std::endl;
+    return false;
+
+  case VISIBLE:
+    std::cout
+        << " Can't assign Internal Attribute 'VISIBLE' via AddActorAttribute "
+           "The Actors class must instead inherit from Theater::Visible"
+        << std::endl;
+    return false;
+
+  case TRANSFORMABLE:
+    std::cout
+        << " Can't assign Internal Attribute 'TRANSFORMABLE' via "
+           "AddActorAttribute "
+           "The Actors class must instead inherit from Theater::Transform2D"
+        << std::endl;
+
+    return false;
+
+#define STAGE_ATTRIBUTE(name)                                                  \
+  case name:                                                                   \
+    _ensemble->handle_##name.insert(act);                                      \
+    act->_attributes.insert(attr);                                             \
+    return true;
+#if __has_include("RayTheaterAttributes.hpp")
+#include "RayTheaterAttributes.hpp"
+#endif // __has_include("RayTheaterAttributes.hpp")
+#undef STAGE_ATTRIBUTE
+
+  default:
+    return false;
+  }
+}
+
+inline bool Stage::RemoveActorAttribute(Actor *act, Attributes attr) {
+
+  if (!isOnStage(act)) {
+    return false;
+  }
+
+  switch (attr) {
+  case DEAD:
+    std::cout << " Can't remove ActorAttribute 'DEAD' via "
+                 "Stage::RemoveActorAttribute"
+              << std::endl;
+    return false;
+
+  case TICKING:
+    std::cout << " Can't remove Internal Attribute 'TICKING' via "
+                 "RemoveActorAttribute "
+              << std::endl;
+    return false;
+
+  case VISIBLE:
+    std::cout << " Can't remove Internal Attribute 'VISIBLE' via "
+                 "RemoveActorAttribute "
+              << std::endl;
+    return false;
+
+  case TRANSFORMABLE:
+    std::cout << " Can't remove Internal Attribute 'TRANSFORMABLE' via "
+                 "RemoveActorAttribute "
+              << std::endl;
+    return false;
+
+#define STAGE_ATTRIBUTE(name)                                                  \
+  case name:                                                                   \
+    _ensemble->handle_##name.erase(act);                                       \
+    act->_attributes.erase(attr);                                              \
+    return true;
+#if __has_include("RayTheaterAttributes.hpp")
+#include "RayTheaterAttributes.hpp"
+#endif // __has_include("RayTheaterAttributes.hpp")
+#undef STAGE_ATTRIBUTE
+
+  default:
+    return false;
+  }
+}
+
+inline bool Stage::isOnStage(Actor *a) {
+  return a->_stageIndex >= 0 &&
+         a->_stageIndex < (int)_ensemble->actors.size() &&
+         _ensemble->actors[a->_stageIndex].actor == a;
+}
+
+// BM: Stage - Implementation - ActorHandles
+//------------------------------------------------------------------------------
+inline unsigned int Stage::takeActorSlot(Actor *a) {
+  if (_freeActorSlots.empty()) {
+    _actorSlots.push_back({a, 1});
+    return _actorSlots.size() - 1;
+  }
+
+  unsigned int slot = _freeActorSlots.back();
+  _freeActorSlots.pop_back();
+  _actorSlots[slot].actor = a;
+  return slot;
+}
+
+inline void Stage::releaseActorSlot(unsigned int slot) {
+  ActorSlot &as = _actorSlots[slot];
+  as.actor = NULL;
+
+  // Invalidates all handles to the slot (0 is left to null handles)
+  if (++as.generation == 0)
+    as.generation = 1;
+  _freeActorSlots.push_back(slot);
+}
+
+inline ActorHandle Stage::GetHandle(Actor *a) {
+  if (a == NULL || !isOnStage(a))
+    return ActorHandle();
+
+  unsigned int slot = _ensemble->actors[a->_stageIndex].handleSlot;
+  return ActorHandle(slot, _actorSlots[slot].generation);
+}
+
+inline Actor *Stage::GetActor(ActorHandle h) {
+  if (h.index >= _actorSlots.size() ||
+      _actorSlots[h.index].generation != h.generation)
+    return NULL;
+
+  return _actorSlots[h.index].actor;
+}
+
+template <typename T> inline T *Stage::GetActor(ActorHandle h) {
+  static_assert(std::is_base_of<Actor, T>::value,
+                "Can't resolve a handle to a class, that does not inherit "
+                "from Theater::Actor");
+
+  return dynamic_cast<T *>(GetActor(h));
+}
+
+// The Actor behind the handle, if it belongs to the current Scene
+inline Stage::StageActor *Stage::stageActor(ActorHandle h) {
+  Actor *a = GetActor(h);
+  if (a == NULL || !isOnStage(a))
+    return NULL;
+
+  return &_ensemble->actors[a->_stageIndex];
+}
+
+inline void Stage::RemoveActor(ActorHandle h) {
+  StageActor *sa = stageActor(h);
+  if (sa != NULL)
+    RemoveActor(sa->actor);
+}
+
+inline bool Stage::MakeActorVisible(ActorHandle h) {
+  StageActor *sa = stageActor(h);
+  if (sa == NULL || sa->visible == NULL)
+    return false;
+
+  return showActor(sa->actor, sa->visible);
+}
+
+inline void Stage::MakeActorInvisible(ActorHandle h) {
+  StageActor *sa = stageActor(h);
+  if (sa == NULL || sa->visible == NULL)
+    return;
+
+  hideActor(sa->actor, sa->visible);
+}
+
+inline bool Stage::AddActorAttribute(ActorHandle h, Attributes attr) {
+  StageActor *sa = stageActor(h);
+  return sa != NULL && AddActorAttribute(sa->actor, attr);
+}
+
+inline bool Stage::RemoveActorAttribute(ActorHandle h, Attributes attr) {
+  StageActor *sa = stageActor(h);
+  return sa != NULL && RemoveActorAttribute(sa->actor, attr);
+}
+
+inline void Stage::ClearStage() {
+
+  // OnStageLeave may remove other Actors, so work through a copy
+  std::vector<StageActor> actors(_ensemble->actors);
+  for (StageActor &sa : actors)
+    if (isOnStage(sa.actor))
+      sa.actor->OnStageLeave(_play);
+
+  for (StageActor &sa : _ensemble->actors) {
+    sa.actor->_stageIndex = -1;
+    sa.actor->_attributes.erase(DEAD);
+    releaseActorSlot(sa.handleSlot);
+  }
+
+  for (unsigned int a = 0; a < _ensemble->renderNodeCnt; a++)
+    if (_ensemble->renderNodes[a].obj != NULL)
+      _ensemble->renderNodes[a].obj->_renderListIndex = -1;
+
+  for (auto &cl : _ensemble->cachedLayers)
+    if (cl.second.texture.id != 0)
+      UnloadRenderTexture(cl.second.texture);
+  _ensemble->cachedLayers.clear();
+
+  // Hand the transforms back to the Actors
+  for (Transform2D *t : _ensemble->transforms.owners)
+    t->leaveStore();
+  _ensemble->transforms = TransformStore();
+
+  _ensemble->actors.clear();
+  _ensemble->tickGroups.clear();
+
+#define STAGE_ATTRIBUTE(name) _ensemble->handle_##name.clear();
+  STAGE_ATTRIBUTE(DEAD)
+  STAGE_ATTRIBUTE(TICKING)
+  STAGE_ATTRIBUTE(VISIBLE)
+
+#if __has_include("RayTheaterAttributes.hpp")
+#include "RayTheaterAttributes.hpp"
+#endif // __has_include("RayTheaterAttributes.hpp")
+#undef STAGE_ATTRIBUTE
+
+  for (int a = 0; a < ACTORLIMIT; a++) {
+    _ensemble->renderNodes[a].obj = NULL;
+    _ensemble->renderNodes[a].next = NULL;
+    _ensemble->renderNodes[a].prev = NULL;
+    _ensemble->renderNodes[a].alive = false;
+    _ensemble->renderNodes[a].index = 0;
+  }
+
+  _ensemble->renderNodeCnt = 0;
+}
+
+inline void Stage::ClearActorFromStage(Actor *a) {
+  if (!isOnStage(a))
+    return;
+
+  a->OnStageLeave(_play);
+
+  // OnStageLeave may already have removed the Actor
+  if (!isOnStage(a))
+    return;
+
+  StageActor sa = _ensemble->actors[a->_stageIndex];
+  a->_attributes.erase(DEAD);
+
+  if (sa.ticking != NULL)
+    leaveTickGroup(sa);
+
+  if (sa.transform != NULL)
+    leaveTransforms(sa.transform);
+
+  if (sa.visible != NULL && sa.visible->_renderListIndex != -1)
+    hideActor(a, sa.visible);
+
+#define STAGE_ATTRIBUTE(name)                                                  \
+  auto act_##name = _ensemble->handle_##name.find(a);                          \
+  if (act_##name != _ensemble->handle_##name.end()) {                          \
+    _ensemble->handle_##name.erase(act_##name);                                \
+  }
+
+  STAGE_ATTRIBUTE(DEAD)
+
+#if __has_include("RayTheaterAttributes.hpp")
+#include "RayTheaterAttributes.hpp"
+#endif // __has_include("RayTheaterAttributes.hpp")
+  STAGE_ATTRIBUTE(VISIBLE)
+#undef STAGE_ATTRIBUTE
+
+  releaseActorSlot(sa.handleSlot);
+
+  // Move the last Actor into the freed slot
+  int index = a->_stageIndex;
+  _ensemble->actors[index] = _ensemble->actors.back();
+  _ensemble->actors[index].actor->_stageIndex = index;
+  _ensemble->actors.pop_back();
+  a->_stageIndex = -1;
+}
+
+// BM: Stage - Implementation - Viewports
+//------------------------------------------------------------------------------
+inline unsigned int Stage::AddViewport(Viewport vp) {
+  vp.active = true;
+  _viewportCnt++;
+
+  for (unsigned int a = 0; a < _viewports.size(); a++)
+    if (!_viewports[a].active) {
+      _viewports[a] = vp;
+      return a;
+    }
+
+  _viewports.push_back(vp);
+  return _viewports.size() - 1;
+}
+
+inline Viewport *Stage::GetViewport(unsigned int id) {
+  if (id >= _viewports.size() || !_viewports[id].active)
+    return NULL;
+  return &_viewports[id];
+}
+
+inline void Stage::RemoveViewport(unsigned int id) {
+  if (GetViewport(id) == NULL)
+    return;
+
+  _viewports[id].active = false;
+  _viewportCnt--;
+}
+
+inline Vector2 Stage::ViewportToWorld(unsigned int id, Vector2 loc) {
+  Viewport *vp = GetViewport(id);
+  if (vp == NULL)
+    return loc;
+
+  // Inverse of the camera: undo offset, zoom, then rotation
+  const Camera2D &cam = vp->camera;
+  float x = (loc.x - vp->rect.x - cam.offset.x) / cam.zoom;
+  float y = (loc.y - vp->rect.y - cam.offset.y) / cam.zoom;
+  float c = std::cos(-cam.rotation * DEG2RAD);
+  float s = std::sin(-cam.rotation * DEG2RAD);
+
+  return {cam.target.x + x * c - y * s, cam.target.y + x * s + y * c};
+}
+
+inline void Stage::buildDrawList() {
+  _drawList.clear();
+
+  bool caching = !_ensemble->cachedLayers.empty();
+  RenderNode<Visible> *rn = _ensemble->renderNodeRoot.next;
+  while (rn != NULL) {
+    if (caching && _ensemble->cachedLayers.count(rn->index) != 0) {
+      // A cached layer is drawn in every Viewport, as one blit
+      DrawItem di = {NULL, rn->index, ~0u, {0, 0, 0, 0}};
+      _drawList.push_back(di);
+
+      int layer = rn->index;
+      while (rn != NULL && rn->index == layer)
+        rn = rn->next;
+      continue;
+    }
+
+    DrawItem di = {rn->obj, rn->index, rn->obj->_viewLayers,
+                   rn->obj->_cullBounds};
+    _drawList.push_back(di);
+    rn = rn->next;
+  }
+}
+
+inline void Stage::drawViewports() {
+  // Sorted once, drawn by every Viewport
+  buildDrawList();
+
+  for (Viewport &vp : _viewports) {
+    if (!vp.active)
+      continue;
+
+    Camera2D cam = vp.camera;
+    cam.offset.x += vp.rect.x;
+    cam.offset.y += vp.rect.y;
+
+    // Area of the world in view, around the (maybe rotated) rect
+    unsigned int id = &vp - &_viewports[0];
+    Vector2 corners[4] = {
+        ViewportToWorld(id, {vp.rect.x, vp.rect.y}),
+        ViewportToWorld(id, {vp.rect.x + vp.rect.width, vp.rect.y}),
+        ViewportToWorld(id, {vp.rect.x, vp.rect.y + vp.rect.height}),
+        ViewportToWorld(id, {vp.rect.x + vp.rect.width,
+                             vp.rect.y + vp.rect.height})};
+    float minX = corners[0].x, maxX = corners[0].x;
+    float minY = corners[0].y, maxY = corners[0].y;
+    for (int a = 1; a < 4; a++) {
+      minX = std::min(minX, corners[a].x);
+      maxX = std::max(maxX, corners[a].x);
+      minY = std::min(minY, corners[a].y);
+      maxY = std::max(maxY, corners[a].y);
+    }
+
+    BeginScissorMode(vp.rect.x, vp.rect.y, vp.rect.width, vp.rect.height);
+    BeginMode2D(cam);
+
+    for (const DrawItem &di : _drawList) {
+      if ((di.viewLayers & vp.layerMask) == 0)
+        continue;
+
+      if (di.obj == NULL) {
+        auto &cl = _ensemble->cachedLayers[di.layer];
+        DrawTextureRec(cl.texture.texture,
+                       {0, 0, _stageWidth, -_stageHeight}, {0, 0}, WHITE);
+        continue;
+      }
+
+      const Rectangle &b = di.bounds;
+      if ((b.width != 0 || b.height != 0) &&
+          (b.x > maxX || b.y > maxY || b.x + b.width < minX ||
+           b.y + b.height < minY))
+        continue;
+
+      di.obj->OnDraw(_play);
+    }
+
+    EndMode2D();
+    EndScissorMode();
+  }
+}
+
+// BM: Stage - Implementation - Tick groups
+//------------------------------------------------------------------------------
+template <typename T> inline void Stage::RegisterActorType() {
+  static_assert(std::is_base_of<Actor, T>::value,
+                "Can't register class, that does not inherit from "
+                "Theater::Actor");
+  static_assert(std::is_base_of<Ticking, T>::value,
+                "Can't register class, that does not implement "
+                "Theater::Ticking");
+
+  std::type_index type(typeid(T));
+  if (_tickGroupIds.find(type) != _tickGroupIds.end())
+    return;
+
+  _tickGroupIds[type] = _tickGroupFns.size();
+  _tickGroupFns.push_back(&Stage::tickGroup<T>);
+}
+
+inline void Stage::joinTickGroup(StageActor &sa) {
+  auto found = _tickGroupIds.find(std::type_index(typeid(*sa.actor)));
+  if (found == _tickGroupIds.end()) {
+    _ensemble->handle_TICKING.insert(sa.ticking);
+    return;
+  }
 
-  /**
-   * @brief Sets the Title for the opened Window
-   *
-   * @param t - title
-   * @return  itself, for easy chaining of setters
-   */
-  Builder Title(const char *t) {
-    _stage._stageTitle = t;
-    return *this;
+  if (_ensemble->tickGroups.size() <= found->second)
+    _ensemble->tickGroups.resize(found->second + 1);
+
+  TickGroup &group = _ensemble->tickGroups[found->second];
+  sa.tickGroup = found->second;
+  sa.tickSlot = group.tickers.size();
+  group.tickers.push_back(sa.ticking);
+  group.owners.push_back(sa.actor);
+}
+
+inline void Stage::leaveTickGroup(StageActor &sa) {
+  if (sa.tickGroup == -1) {
+    _ensemble->handle_TICKING.erase(sa.ticking);
+    return;
   }
 
-  /**
-   * @brief changes the color fo the border, that is shown, when
-   * the window is scaled to a different aspect ratio
-   *
-   * @param c  - Raylib Color
-   * @return  itself for easy chaining of setters
-   */
-  Builder BorderColor(Color c) {
-    _stage._borderColor = c;
-    return *this;
+  // Move the last member into the freed slot
+  TickGroup &group = _ensemble->tickGroups[sa.tickGroup];
+  group.tickers[sa.tickSlot] = group.tickers.back();
+  group.owners[sa.tickSlot] = group.owners.back();
+  _ensemble->actors[group.owners[sa.tickSlot]->_stageIndex].tickSlot =
+      sa.tickSlot;
+
+  group.tickers.pop_back();
+  group.owners.pop_back();
+  sa.tickGroup = -1;
+}
+
+// BM: Stage - Implementation - Transforms
+//------------------------------------------------------------------------------
+inline void Stage::joinTransforms(Transform2D *t) {
+  TransformStore &ts = _ensemble->transforms;
+  t->_store = &ts;
+  t->_storeIndex = ts.Size();
+  t->_dirty = false;
+
+  ts.x.push_back(t->loc.x);
+  ts.y.push_back(t->loc.y);
+  ts.rotation.push_back(t->rotation);
+  ts.scale.push_back(t->scale);
+  ts.nextX.push_back(t->_loc.x);
+  ts.nextY.push_back(t->_loc.y);
+  ts.nextRotation.push_back(t->_rotation);
+  ts.nextScale.push_back(t->_scale);
+  ts.worldX.push_back(0);
+  ts.worldY.push_back(0);
+  ts.worldRotation.push_back(0);
+  ts.worldScale.push_back(1);
+  ts.owners.push_back(t);
+
+  t->computeWorld();
+  ts.MarkDirty(t->_storeIndex);
+
+  // Children already on the Stage are now relative to the stored values
+  for (Transform2D *child : t->_children)
+    if (child->_store == &ts)
+      ts.MarkDirty(child->_storeIndex);
+}
+
+inline void Stage::leaveTransforms(Transform2D *t) {
+  if (_ensemble->tweens.Count() != 0)
+    _ensemble->tweens.CancelTarget(t);
+
+  TransformStore &ts = _ensemble->transforms;
+  unsigned int index = t->_storeIndex;
+
+  if (t->_dirty)
+    for (size_t a = 0; a < ts.dirty.size(); a++)
+      if (ts.dirty[a] == t) {
+        ts.dirty[a] = ts.dirty.back();
+        ts.dirty.pop_back();
+        break;
+      }
+
+  // Keep the values with the Actor, for when it returns to the Stage
+  t->leaveStore();
+
+  // Move the last entry into the freed slot
+  std::vector<float> *values[] = {
+      &ts.x,         &ts.y,         &ts.rotation,  &ts.scale,
+      &ts.nextX,     &ts.nextY,     &ts.nextRotation, &ts.nextScale,
+      &ts.worldX,    &ts.worldY,    &ts.worldRotation, &ts.worldScale};
+  for (std::vector<float> *v : values) {
+    (*v)[index] = v->back();
+    v->pop_back();
   }
 
-  /**
-   * @brief sets the cleard background-color of the Stage
-   *
-   * @param c - Raylib Color
-   * @return  itself for easy chainging of setters
-   */
-  Builder BackgroundColor(Color c) {
-    _stage._backgroundColor = c;
-    return *this;
+  ts.owners[index] = ts.owners.back();
+  ts.owners[index]->_storeIndex = index;
+  ts.owners.pop_back();
+
+  for (Transform2D *child : t->_children)
+    if (child->_store == &ts)
+      ts.MarkDirty(child->_storeIndex);
+}
+
+inline void Stage::flipTransforms() {
+  TransformStore &ts = _ensemble->transforms;
+  size_t n = ts.Size();
+  _transformQueue.clear();
+
+  if (ts.allDirty) {
+    ts.allDirty = false;
+    if (n > 0) {
+      std::memcpy(ts.x.data(), ts.nextX.data(), n * sizeof(float));
+      std::memcpy(ts.y.data(), ts.nextY.data(), n * sizeof(float));
+      std::memcpy(ts.rotation.data(), ts.nextRotation.data(),
+                  n * sizeof(float));
+      std::memcpy(ts.scale.data(), ts.nextScale.data(), n * sizeof(float));
+    }
+
+    // Recompute everything, starting at the roots
+    for (Transform2D *t : ts.owners)
+      if (t->_parent == NULL || t->_parent->_store != &ts)
+        _transformQueue.push_back(t);
+    updateWorldTransforms(0);
+
+    for (Transform2D *t : ts.dirty)
+      t->_dirty = false;
+    ts.dirty.clear();
+    return;
   }
 
-  /**
-   * @brief Opens the window and starts playing the given Scene
-   * @param sc
-   */
-  void Play(Scene *sc) { _stage.Play(sc); }
+  // Nothing changed, nothing to do
+  if (ts.dirty.empty())
+    return;
 
-private:
-  Stage _stage;
-};
+  for (Transform2D *t : ts.dirty) {
+    unsigned int i = t->_storeIndex;
+    ts.x[i] = ts.nextX[i];
+    ts.y[i] = ts.nextY[i];
+    ts.rotation[i] = ts.nextRotation[i];
+    ts.scale[i] = ts.nextScale[i];
+  }
 
-// BM: Stage - Implementation
-//==============================================================================
-inline Stage::Stage(int width, int height, float scale)
-    : _scene(0x0), _viewportOrigin({0, 0}),
-      _stageRect(
-          {0, 0, static_cast<float>(width), static_cast<float>(-height)}),
-      _viewportRect({0, 0, static_cast<float>(width) * scale,
-                     static_cast<float>(height) * scale}),
-      _stageWidth(width), _stageHeight(height), _play(),
-      _backgroundColor(Color{0x00, 0x00, 0xAA, 0xff}),
-      _borderColor(Color{0x00, 0x88, 0xff, 0xff}), _handle_TICKING(),
-      _handle_DEAD(), _handle_TRANSFORMABLE(), _stageScale(scale),
-      _actorsToClear(), _stageTitle("< RayWrapC - Project >"), _renderNodes(),
-      _rendering(false), _tickingPaused(false) {
+  // Parents first, so each subtree is only updated once
+  std::sort(ts.dirty.begin(), ts.dirty.end(),
+            [](Transform2D *a, Transform2D *b) {
+              return a->_depth < b->_depth;
+            });
 
-  static_assert(ACTORLIMIT > 0, "Set ACTORLIMIT must be bigger than 0");
+  for (Transform2D *t : ts.dirty) {
+    // Already updated together with one of its parents
+    if (!t->_dirty)
+      continue;
+
+    size_t first = _transformQueue.size();
+    _transformQueue.push_back(t);
+    updateWorldTransforms(first);
+  }
+
+  ts.dirty.clear();
+}
+
+// Breadth first through the subtrees queued from first on
+inline void Stage::updateWorldTransforms(size_t first) {
+  TransformStore &ts = _ensemble->transforms;
+
+  for (size_t q = first; q < _transformQueue.size(); q++) {
+    Transform2D *t = _transformQueue[q];
+    if (t->_store == &ts) {
+      t->_dirty = false;
+      t->computeWorld();
+    }
+
+    for (Transform2D *child : t->_children)
+      _transformQueue.push_back(child);
+  }
+}
+
+inline TransformStore &Stage::Transforms() { return _ensemble->transforms; }
+
+inline TweenEngine &Stage::Tweens() { return _ensemble->tweens; }
+
+template <typename T> inline T &Stage::SceneState() {
+  // The address of a static per T serves as its key
+  static const char key = 0;
+
+  std::shared_ptr<void> &state = _ensemble->states[&key];
+  if (!state)
+    state = std::make_shared<T>();
+  return *static_cast<T *>(state.get());
+}
+
+inline std::unordered_set<Actor *>
+Stage::GetActorsWithAttribute(Attributes attr) {
+  switch (attr) {
+  case TICKING:
+  case TRANSFORMABLE:
+  case VISIBLE:
+  case DEAD:
+    std::cerr << "can't request Actors for Internal Attributes" << std::endl;
+  default:
+    return std::unordered_set<Actor *>();
+
+#define STAGE_ATTRIBUTE(name)                                                  \
+  case name:                                                                   \
+    return _ensemble->handle_##name;
 
-  // Attributes Initialized
-  //----------------------------------------------------------------------------
-#define STAGE_ATTRIBUTE(name) _handle_##name = std::unordered_set<Actor *>();
 #if __has_include("RayTheaterAttributes.hpp")
 #include "RayTheaterAttributes.hpp"
-  STAGE_ATTRIBUTE(VISIBLE);
-#endif // __has_include("RayTheaterAttributes.hpp")
-
+#endif
 #undef STAGE_ATTRIBUTE
+  }
+}
 
-  ClearStage();
-  _renderNodeRoot.next = NULL;
-  _renderNodeRoot.prev = NULL;
-  _renderNodeRoot.obj = NULL;
-  _renderNodeRoot.alive = false;
-  _renderNodeRoot.index = INT_MIN;
+// BM: WorkerPool - Implementation
+//==============================================================================
+inline WorkerPool::WorkerPool(unsigned int threads)
+    : _size(threads), _stopping(false), _running(0), _threads(), _jobs() {
+  if (_size == 0) {
+    unsigned int cores = std::thread::hardware_concurrency();
+    _size = cores > 2 ? std::min(cores - 1, 4u) : 1;
+  }
 }
 
-// BM: Stage - Implementation - Play
-//------------------------------------------------------------------------------
-inline void Stage::Play(Scene *sc) {
+inline WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+    _jobs.clear();
+  }
+  _wake.notify_all();
 
-  // Setup the Window
-  SetConfigFlags(FLAG_WINDOW_RESIZABLE);
-  InitWindow(_viewportRect.width, _viewportRect.height, _stageTitle);
-  if (!IsWindowReady()) {
-    throw "window not ready";
+  for (std::thread &t : _threads)
+    t.join();
+}
+
+inline void WorkerPool::Run(std::function<void()> job) { push(job, false); }
+
+inline void WorkerPool::push(std::function<void()> job, bool front) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_threads.empty())
+      for (unsigned int a = 0; a < _size; a++)
+        _threads.push_back(std::thread(&WorkerPool::work, this));
+
+    if (front)
+      _jobs.push_front(job);
+    else
+      _jobs.push_back(job);
   }
+  _wake.notify_one();
+}
 
-  // Setup the Render-Area / Stage-Texture
-  _stage = LoadRenderTexture(_stageWidth, _stageHeight);
-  if (!IsRenderTextureReady(_stage)) {
-    CloseWindow();
-    throw "failed to create render texture";
+inline void WorkerPool::ParallelFor(size_t count, size_t minChunk,
+                                    std::function<void(size_t, size_t)> job) {
+  size_t chunks = minChunk > 0 ? count / minChunk : count;
+  chunks = std::min(chunks, (size_t)_size + 1);
+  if (chunks <= 1) {
+    job(0, count);
+    return;
   }
 
-  // Prepare the _play - context
+  // Rounding the size up may need fewer chunks, than asked for
+  size_t chunkSize = (count + chunks - 1) / chunks;
+  chunks = (count + chunkSize - 1) / chunkSize;
+
+  // Whoever comes first, claims the next chunk. Shared, since queued
+  // helpers may only start, after all chunks are done and this returned.
+  struct Shared {
+    std::atomic<size_t> next;
+    size_t done;
+    std::mutex mutex;
+    std::condition_variable wake;
+  };
+  std::shared_ptr<Shared> shared = std::make_shared<Shared>();
+  shared->next = 0;
+  shared->done = 0;
+
+  std::shared_ptr<std::function<void(size_t, size_t)>> work =
+      std::make_shared<std::function<void(size_t, size_t)>>(job);
+
+  auto claim = [shared, work, count, chunks, chunkSize]() {
+    size_t c;
+    while ((c = shared->next++) < chunks) {
+      size_t begin = c * chunkSize;
+      (*work)(begin, std::min(count, begin + chunkSize));
+
+      std::lock_guard<std::mutex> lock(shared->mutex);
+      if (++shared->done == chunks)
+        shared->wake.notify_one();
+    }
+  };
 
-  _play.stage = this;
-  _play.stageWidth = _stageWidth;
-  _play.stageHeight = _stageHeight;
+  for (size_t c = 1; c < chunks; c++)
+    push(claim, true);
 
-  // Activate the given scene
-  switchScene(sc);
+  claim();
 
-  // Start the main-Loop
-  while (!WindowShouldClose() && _scene != NULL) {
+  std::unique_lock<std::mutex> lock(shared->mutex);
+  shared->wake.wait(lock, [&] { return shared->done == chunks; });
+}
 
-    // Tick the Scene with the state crated by the last frame.
-    if (!_scene->Tick(_play)) {
-      // If the scene should end, attempt a scene Switch instead of
-      // continuing.
-      switchScene(NULL);
-      continue;
+inline unsigned int WorkerPool::Threads() { return _size; }
+
+inline unsigned int WorkerPool::Pending() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _jobs.size() + _running;
+}
+
+inline void WorkerPool::work() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+      if (_stopping)
+        return;
+
+      job = _jobs.front();
+      _jobs.pop_front();
+      _running++;
     }
 
-    // Remove all Actors, that have been killed in the last cycle.
-    for (auto dead : _handle_DEAD)
-      ClearActorFromStage(dead);
+    job();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _running--;
+  }
+}
 
-    // Flip all the Actors State
-    for (auto act : _handle_TRANSFORMABLE)
-      act->FlipTransform2DStates();
+// BM: ResourceCache - Implementation
+//==============================================================================
+inline ResourceCache::ResourceCache(std::shared_ptr<WorkerPool> workers)
+    : _workers(workers), _inbox(new Inbox()), _slots(), _freeSlots(),
+      _keys(), _useCounter(0), _pending(0), _budget(RESOURCE_BUDGET),
+      _usage(0) {
+  // Slot 0 is never used, so a default handle is always invalid
+  _slots.push_back(Slot());
+  _slots[0].generation = 0;
+  _slots[0].state = SLOT_FREE;
+}
 
-    // React to Window being resized
-    if (IsWindowResized())
-      onResize();
+inline ResourceCache::~ResourceCache() { Clear(); }
 
-    // Put DeltaTime - Multiplyer into context
-    _play.deltaTime = GetFrameTime();
+inline ResourceCache::Inbox::~Inbox() {
+  for (Upload &u : uploads)
+    freeUpload(u);
+}
+
+inline TextureHandle ResourceCache::AcquireTexture(const char *path) {
+  bool created;
+  TextureHandle h;
+  h.slot = acquire(path, false, &created);
+  h.generation = _slots[h.slot].generation;
+
+  if (created) {
+    Upload u = {};
+    u.slot = h.slot;
+    u.generation = h.generation;
+    u.path = path;
+
+    std::shared_ptr<Inbox> inbox = _inbox;
+    _workers->Run([inbox, u]() mutable {
+      decode(u);
+      std::lock_guard<std::mutex> lock(inbox->mutex);
+      inbox->uploads.push_back(u);
+    });
+  }
+
+  return h;
+}
+
+inline FontHandle ResourceCache::AcquireFont(const char *path, int fontSize) {
+  bool created;
+  FontHandle h;
+  h.slot = acquire(std::string(path) + "#" + std::to_string(fontSize), true,
+                   &created);
+  h.generation = _slots[h.slot].generation;
+
+  if (created) {
+    Upload u = {};
+    u.slot = h.slot;
+    u.generation = h.generation;
+    u.isFont = true;
+    u.path = path;
+    u.fontSize = fontSize;
+
+    std::shared_ptr<Inbox> inbox = _inbox;
+    _workers->Run([inbox, u]() mutable {
+      decode(u);
+      std::lock_guard<std::mutex> lock(inbox->mutex);
+      inbox->uploads.push_back(u);
+    });
+  }
 
-    // Update MousePosition
-    _play.mouseLoc = Vector2({(float)GetMouseX(), (float)GetMouseY()});
+  return h;
+}
+
+template <typename T> inline void ResourceCache::Acquire(ResourceHandle<T> h) {
+  Slot *s = slotOf(h.slot, h.generation);
+  if (s != NULL)
+    s->refs++;
+}
+
+template <typename T> inline void ResourceCache::Release(ResourceHandle<T> h) {
+  release(h.slot, h.generation);
+}
+
+template <typename T> inline bool ResourceCache::IsReady(ResourceHandle<T> h) {
+  Slot *s = slotOf(h.slot, h.generation);
+  return s != NULL && s->state == SLOT_READY;
+}
+
+template <typename T> inline bool ResourceCache::IsValid(ResourceHandle<T> h) {
+  return slotOf(h.slot, h.generation) != NULL;
+}
+
+inline Texture2D ResourceCache::GetTexture(TextureHandle h) {
+  Slot *s = slotOf(h.slot, h.generation);
+  if (s == NULL || s->state != SLOT_READY || s->isFont)
+    return Texture2D{};
+
+  s->lastUsed = ++_useCounter;
+  return s->texture;
+}
+
+inline Font ResourceCache::GetFont(FontHandle h) {
+  Slot *s = slotOf(h.slot, h.generation);
+  if (s == NULL || s->state != SLOT_READY || !s->isFont)
+    return GetFontDefault();
+
+  s->lastUsed = ++_useCounter;
+  return s->font;
+}
+
+inline unsigned int ResourceCache::Pending() { return _pending; }
 
-    _play.mouseLoc.x -= _viewportRect.x;
-    _play.mouseLoc.y -= _viewportRect.y;
+inline void ResourceCache::Budget(size_t bytes) {
+  _budget = bytes;
+  evict();
+}
+
+inline size_t ResourceCache::Usage() { return _usage; }
+
+inline ResourceCache::Slot *ResourceCache::slotOf(unsigned int slot,
+                                                  unsigned int generation) {
+  if (slot == 0 || slot >= _slots.size() ||
+      _slots[slot].generation != generation ||
+      _slots[slot].state == SLOT_FREE)
+    return NULL;
+
+  return &_slots[slot];
+}
+
+inline unsigned int ResourceCache::acquire(const std::string &key,
+                                           bool isFont, bool *created) {
+  auto found = _keys.find(key);
+  if (found != _keys.end()) {
+    _slots[found->second].refs++;
+    *created = false;
+    return found->second;
+  }
+
+  unsigned int slot;
+  if (_freeSlots.empty()) {
+    slot = _slots.size();
+    _slots.push_back(Slot());
+    _slots[slot].generation = 1;
+  } else {
+    slot = _freeSlots.back();
+    _freeSlots.pop_back();
+  }
+
+  Slot &s = _slots[slot];
+  s.key = key;
+  s.refs = 1;
+  s.state = SLOT_LOADING;
+  s.isFont = isFont;
+  s.texture = Texture2D{};
+  s.font = Font{};
+  s.bytes = 0;
+  s.lastUsed = ++_useCounter;
+
+  _keys[key] = slot;
+  _pending++;
+  *created = true;
+  return slot;
+}
+
+inline void ResourceCache::release(unsigned int slot,
+                                   unsigned int generation) {
+  Slot *s = slotOf(slot, generation);
+  if (s == NULL || s->refs == 0)
+    return;
+
+  s->refs--;
+  s->lastUsed = ++_useCounter;
+
+  if (s->refs == 0) {
+    if (s->state == SLOT_FAILED)
+      unloadSlot(slot);
+    else
+      evict();
+  }
+}
 
-    _play.mouseLoc.x /= _stageScale;
-    _play.mouseLoc.y /= _stageScale;
+inline void ResourceCache::unloadSlot(unsigned int slot) {
+  Slot &s = _slots[slot];
 
-    _play.mouseX = std::floor(_play.mouseLoc.x);
-    _play.mouseY = std::floor(_play.mouseLoc.y);
+  if (s.state == SLOT_READY) {
+    if (s.isFont)
+      UnloadFont(s.font);
+    else
+      UnloadTexture(s.texture);
+    _usage -= s.bytes;
+  }
 
-    // Update MouseButtons
-    _play.mouseReleased = _play.mouseHeld | _play.mouseDown;
-    _play.mouseHeld = 0;
-    _play.mouseUp = 0;
-    _play.mouseDown = 0;
+  _keys.erase(s.key);
+  s.key.clear();
+  s.state = SLOT_FREE;
+  s.refs = 0;
+  s.generation++;
+  _freeSlots.push_back(slot);
+}
 
-    for (unsigned char a = 1; a < 7; a++) {
-      _play.mouseDown |= (IsMouseButtonPressed(a - 1) ? 1 : 0) << a;
-      _play.mouseHeld |= (IsMouseButtonDown(a - 1) ? 1 : 0) << a;
-      _play.mouseUp |= (IsMouseButtonUp(a - 1) ? 1 : 0) << a;
+inline void ResourceCache::evict() {
+  while (_usage > _budget) {
+    unsigned int oldest = 0;
+    for (unsigned int a = 1; a < _slots.size(); a++) {
+      Slot &s = _slots[a];
+      if (s.state == SLOT_READY && s.refs == 0 &&
+          (oldest == 0 || s.lastUsed < _slots[oldest].lastUsed))
+        oldest = a;
     }
 
-    // Just in case held and Pressed overlap => remove Pressed from held.
-    _play.mouseHeld &= ~_play.mouseDown;
-    _play.mouseUp &= ~(_play.mouseDown | _play.mouseHeld);
-    _play.mouseReleased &= _play.mouseUp;
-
-    // Tick all the actors
-    if (!_tickingPaused)
-      for (Ticking *ticker : _handle_TICKING)
-        ticker->OnTick(_play);
-
-    // Figure out the Render order of actors;
-    int rnCnt = _renderNodeCnt;
-    RenderNode<Visible> *rn = &_renderNodeRoot;
-    rn->next = NULL;
-    for (int a = 0; a < rnCnt; a++) {
-      auto node = &(_renderNodes[a]);
-      node->index = node->obj->_zindex;
-
-      if (node->alive == false)
-        continue;
+    // Everything left is still in use
+    if (oldest == 0)
+      return;
+
+    unloadSlot(oldest);
+  }
+}
 
-      if (node->index >= rn->index) {
-        while (rn->next != NULL && rn->next->index <= node->index)
-          rn = rn->next;
+// Runs on a worker: reads and decodes the file, without touching the GPU
+inline void ResourceCache::decode(Upload &u) {
+  if (!u.isFont) {
+    u.image = LoadImage(u.path.c_str());
+    return;
+  }
 
-        node->next = NULL;
-        if (rn->next != NULL) {
-          rn->next->prev = node;
-          node->next = rn->next;
-        }
+  // Only TTF/OTF can be decoded without the GPU, everything else is left
+  // for RayLibs LoadFont on the main thread
+  std::string ext = u.path.size() > 4 ? u.path.substr(u.path.size() - 4) : "";
+  if (ext != ".ttf" && ext != ".otf" && ext != ".TTF" && ext != ".OTF")
+    return;
 
-        rn->next = node;
-        node->prev = rn;
+  int size = 0;
+  unsigned char *data = LoadFileData(u.path.c_str(), &size);
+  if (data == NULL)
+    return;
 
-      } else if (node->index < rn->index) {
-        while (rn->prev != NULL && rn->prev->index > node->index)
-          rn = rn->prev;
+  u.glyphCount = 95;
+  u.glyphs =
+      LoadFontData(data, size, u.fontSize, NULL, u.glyphCount, FONT_DEFAULT);
+  if (u.glyphs != NULL)
+    u.image = GenImageFontAtlas(u.glyphs, &u.recs, u.glyphCount, u.fontSize,
+                                4, 0);
+  UnloadFileData(data);
+}
 
-        rn->prev->next = node;
-        node->prev = rn->prev;
-        node->next = rn;
-        rn->prev = node;
-      }
+inline void ResourceCache::freeUpload(Upload &u) {
+  if (u.image.data != NULL)
+    UnloadImage(u.image);
+  if (u.glyphs != NULL)
+    UnloadFontData(u.glyphs, u.glyphCount);
+  if (u.recs != NULL)
+    MemFree(u.recs);
+  u = Upload();
+}
 
-      rn = node;
+inline void ResourceCache::Update() {
+  for (int a = 0; a < RESOURCE_UPLOADS_PER_CYCLE; a++) {
+    Upload u;
+    {
+      std::lock_guard<std::mutex> lock(_inbox->mutex);
+      if (_inbox->uploads.empty())
+        break;
+
+      u = _inbox->uploads.front();
+      _inbox->uploads.pop_front();
+    }
+
+    Slot *s = slotOf(u.slot, u.generation);
+    if (s == NULL || s->state != SLOT_LOADING) {
+      freeUpload(u);
+      continue;
+    }
+
+    _pending--;
+
+    if (!u.isFont && u.image.data != NULL) {
+      s->texture = LoadTextureFromImage(u.image);
+      s->bytes = (size_t)u.image.width * u.image.height * 4;
+      UnloadImage(u.image);
+
+    } else if (u.isFont && u.image.data != NULL) {
+      s->font.baseSize = u.fontSize;
+      s->font.glyphCount = u.glyphCount;
+      s->font.glyphPadding = 4;
+      s->font.glyphs = u.glyphs;
+      s->font.recs = u.recs;
+      s->font.texture = LoadTextureFromImage(u.image);
+      s->bytes = (size_t)u.image.width * u.image.height * 4;
+      UnloadImage(u.image);
+
+    } else if (u.isFont && u.glyphs == NULL && FileExists(u.path.c_str())) {
+      s->font = LoadFontEx(u.path.c_str(), u.fontSize, NULL, 0);
+      s->bytes = (size_t)s->font.texture.width * s->font.texture.height * 4;
+    }
+
+    if (s->texture.id == 0 && s->font.texture.id == 0) {
+      std::cerr << "ResourceCache: failed to load '" << u.path << "'"
+                << std::endl;
+      s->state = SLOT_FAILED;
+      if (s->refs == 0)
+        unloadSlot(u.slot);
+      continue;
     }
 
-    _rendering = true;
+    s->state = SLOT_READY;
+    _usage += s->bytes;
+  }
+
+  evict();
+}
+
+inline void ResourceCache::Clear() {
+  for (unsigned int a = 1; a < _slots.size(); a++)
+    if (_slots[a].state != SLOT_FREE)
+      unloadSlot(a);
+
+  _pending = 0;
+}
+
+// BM: TweenEngine - Implementation
+//==============================================================================
+inline TweenEngine::TweenEngine()
+    : _floats(), _vectors(), _colors(), _locs(), _nextHandle(0),
+      _finished() {}
+
+inline TweenHandle TweenEngine::To(float *target, float to, float seconds,
+                                   Ease ease, t_TweenDoneHandler done) {
+  return _floats.add(nextHandle(), target, *target, to, seconds, ease, done);
+}
+
+inline TweenHandle TweenEngine::To(Vector2 *target, Vector2 to, float seconds,
+                                   Ease ease, t_TweenDoneHandler done) {
+  return _vectors.add(nextHandle(), target, *target, to, seconds, ease, done);
+}
+
+inline TweenHandle TweenEngine::To(Color *target, Color to, float seconds,
+                                   Ease ease, t_TweenDoneHandler done) {
+  return _colors.add(nextHandle(), target, *target, to, seconds, ease, done);
+}
+
+inline TweenHandle TweenEngine::MoveTo(Transform2D *target, Vector2 to,
+                                       float seconds, Ease ease,
+                                       t_TweenDoneHandler done) {
+  return _locs.add(nextHandle(), target, target->getNextLoc(), to, seconds,
+                   ease, done);
+}
+
+inline bool TweenEngine::Cancel(TweenHandle h) {
+  return _floats.cancel(h) || _vectors.cancel(h) || _colors.cancel(h) ||
+         _locs.cancel(h);
+}
+
+inline void TweenEngine::CancelTarget(const void *target) {
+  _floats.cancelTarget(target);
+  _vectors.cancelTarget(target);
+  _colors.cancelTarget(target);
+  _locs.cancelTarget(target);
+}
+
+inline bool TweenEngine::IsRunning(TweenHandle h) {
+  return _floats.has(h) || _vectors.has(h) || _colors.has(h) || _locs.has(h);
+}
+
+inline unsigned int TweenEngine::Count() {
+  return _floats.handles.size() + _vectors.handles.size() +
+         _colors.handles.size() + _locs.handles.size();
+}
+
+inline float TweenEngine::Apply(Ease ease, float t) {
+  switch (ease) {
+  case EASE_LINEAR:
+    return t;
+  case EASE_IN_QUAD:
+    return t * t;
+  case EASE_OUT_QUAD:
+    return t * (2 - t);
+  case EASE_IN_OUT_QUAD:
+    return t < 0.5f ? 2 * t * t : -1 + (4 - 2 * t) * t;
+  case EASE_IN_CUBIC:
+    return t * t * t;
+  case EASE_OUT_CUBIC:
+    t -= 1;
+    return t * t * t + 1;
+  case EASE_IN_OUT_CUBIC:
+    return t < 0.5f ? 4 * t * t * t
+                    : (t - 1) * (2 * t - 2) * (2 * t - 2) + 1;
+  case EASE_IN_SINE:
+    return 1 - std::cos(t * PI * 0.5f);
+  case EASE_OUT_SINE:
+    return std::sin(t * PI * 0.5f);
+  case EASE_IN_OUT_SINE:
+    return 0.5f * (1 - std::cos(t * PI));
+  case EASE_OUT_BACK:
+    t -= 1;
+    return 1 + t * t * (2.70158f * t + 1.70158f);
+  }
+  return t;
+}
+
+inline TweenHandle TweenEngine::nextHandle() {
+  // 0 is never handed out
+  if (++_nextHandle == 0)
+    ++_nextHandle;
+  return _nextHandle;
+}
+
+inline Color TweenEngine::lerp(Color f, Color t, float e) {
+  return {channel(f.r, t.r, e), channel(f.g, t.g, e), channel(f.b, t.b, e),
+          channel(f.a, t.a, e)};
+}
+
+// Easings like EASE_OUT_BACK overshoot past 0 and 1; a channel out of
+// [0, 255] can't be cast to unsigned char
+inline unsigned char TweenEngine::channel(unsigned char f, unsigned char t,
+                                          float e) {
+  float v = f + (t - f) * e;
+  return (unsigned char)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+inline void TweenEngine::update(float dt) {
+  _floats.update(dt, _finished);
+  _vectors.update(dt, _finished);
+  _colors.update(dt, _finished);
+  _locs.update(dt, _finished);
+
+  if (_finished.empty())
+    return;
+
+  // Handlers may start new tweens, so they run after all tweens moved
+  std::vector<t_TweenDoneHandler> finished;
+  finished.swap(_finished);
+  for (auto &handler : finished)
+    handler();
+}
+
+template <typename T, typename Target>
+inline TweenHandle
+TweenEngine::Track<T, Target>::add(TweenHandle h, Target *target, T f, T t,
+                                   float seconds, Ease e,
+                                   t_TweenDoneHandler d) {
+  targets.push_back(target);
+  from.push_back(f);
+  to.push_back(t);
+  time.push_back(0);
+  rate.push_back(seconds > 0 ? 1.0f / seconds : 1e9f);
+  eased.push_back(0);
+  ease.push_back(e);
+  handles.push_back(h);
+  done.push_back(d);
+  return h;
+}
 
-    // Start drawing on the Stage
-    BeginTextureMode(_stage);
-    ClearBackground(_backgroundColor);
+// Moves the last tween into the slot of the removed one
+template <typename T, typename Target>
+inline void TweenEngine::Track<T, Target>::remove(size_t i) {
+  targets[i] = targets.back();
+  from[i] = from.back();
+  to[i] = to.back();
+  time[i] = time.back();
+  rate[i] = rate.back();
+  ease[i] = ease.back();
+  handles[i] = handles.back();
+  done[i].swap(done.back());
+
+  targets.pop_back();
+  from.pop_back();
+  to.pop_back();
+  time.pop_back();
+  rate.pop_back();
+  eased.pop_back();
+  ease.pop_back();
+  handles.pop_back();
+  done.pop_back();
+}
 
-    rn = _renderNodeRoot.next;
-    while (rn != NULL) {
-      rn->obj->OnDraw(_play);
-      rn = rn->next;
+template <typename T, typename Target>
+inline bool TweenEngine::Track<T, Target>::cancel(TweenHandle h) {
+  for (size_t a = 0; a < handles.size(); a++)
+    if (handles[a] == h) {
+      remove(a);
+      return true;
     }
+  return false;
+}
 
-    _scene->OnStageDraw(_play);
-    EndTextureMode();
-
-    // Start drawing on the Stage
-    BeginDrawing();
-    ClearBackground(_borderColor);
-    DrawTexturePro(_stage.texture, _stageRect, _viewportRect, _viewportOrigin,
-                   0, WHITE);
-    _scene->OnWindowDraw(_play);
-    EndDrawing();
-
-    _rendering = false;
+template <typename T, typename Target>
+inline void TweenEngine::Track<T, Target>::cancelTarget(const void *target) {
+  size_t a = 0;
+  while (a < targets.size()) {
+    if (targets[a] == target)
+      remove(a);
+    else
+      a++;
   }
+}
 
-  switchScene(0);
-  ClearStage();
-  UnloadRenderTexture(_stage);
+template <typename T, typename Target>
+inline bool TweenEngine::Track<T, Target>::has(TweenHandle h) {
+  return std::find(handles.begin(), handles.end(), h) != handles.end();
 }
 
-inline void Stage::Pause() { _tickingPaused = true; }
-inline void Stage::UnPause() { _tickingPaused = false; }
+template <typename T, typename Target>
+inline void TweenEngine::Track<T, Target>::update(
+    float dt, std::vector<t_TweenDoneHandler> &finished) {
+  size_t cnt = handles.size();
+  if (cnt == 0)
+    return;
 
-inline void Stage::switchScene(Scene *sc) {
-  _sceneUnloading = true;
+  // Plain loop over the progress, so the compiler can vectorize it
+  float *__restrict tm = time.data();
+  const float *__restrict rt = rate.data();
+  for (size_t i = 0; i < cnt; i++)
+    tm[i] = std::min(1.0f, tm[i] + rt[i] * dt);
 
-  if (_scene != NULL) {
+  for (size_t i = 0; i < cnt; i++)
+    eased[i] = Apply((Ease)ease[i], tm[i]);
 
-    if (sc == NULL)
-      sc = _scene->Unload(_play);
-    else
-      _scene->Unload(_play);
+  for (size_t i = 0; i < cnt; i++)
+    apply(targets[i], lerp(from[i], to[i], eased[i]));
 
-    _scene = NULL;
-  }
+  // Collect the finished ones
+  size_t a = 0;
+  while (a < handles.size()) {
+    if (time[a] < 1.0f) {
+      a++;
+      continue;
+    }
 
-  if (sc != NULL) {
-    sc->OnStart(_play);
-    _scene = sc;
+    if (done[a])
+      finished.push_back(std::move(done[a]));
+    remove(a);
   }
+}
 
-  _sceneUnloading = false;
+// BM: FramePacer - Implementation
+//==============================================================================
+inline FramePacer::FramePacer()
+    : fps(0), lowLatency(false), _frameTimes(FRAME_STATS_SAMPLES),
+      _latencies(FRAME_STATS_SAMPLES), _cursor(0), _count(0) {}
+
+inline void FramePacer::Start() {
+  _next = Clock::now();
+  _lastFrame = _next;
+  _inputAt = _next;
+  _cursor = 0;
+  _count = 0;
 }
 
-inline void Stage::BorderColor(Color c) { _borderColor = c; }
+inline void FramePacer::Wait() {
+  if (fps <= 0)
+    return;
 
-inline void Stage::BackgroundColor(Color c) { _backgroundColor = c; }
+  Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / fps));
+  Clock::time_point now = Clock::now();
 
-inline void Stage::onResize() {
-  float screenWidth = GetScreenWidth();
-  float screenHeight = GetScreenHeight();
-  float scale =
-      ::std::min(screenWidth / _stageWidth, screenHeight / _stageHeight);
+  // Fell behind by more than a frame: don't rush to catch up
+  _next += period;
+  if (_next < now - period)
+    _next = now;
 
-  _stageScale = scale;
-  _viewportRect.width = _stageWidth * scale;
-  _viewportRect.height = _stageHeight * scale;
-  _viewportRect.x = (screenWidth - _viewportRect.width) * 0.5;
-  _viewportRect.y = (screenHeight - _viewportRect.height) * 0.5;
+  // Sleep most of the way, the OS may oversleep a bit; spin the rest
+  Clock::time_point spinFrom =
+      _next - std::chrono::microseconds(FRAME_SPIN_MICROSECONDS);
+  if (now < spinFrom)
+    std::this_thread::sleep_until(spinFrom);
+
+  while (Clock::now() < _next)
+    std::this_thread::yield();
 }
 
-template <typename T> inline void Stage::AddActor(T *a) {
-  static_assert(std::is_base_of<Actor, T>::value,
-                "Can't add class, that does not inherit from Theater::Actor");
+inline void FramePacer::InputSampled() { _inputAt = Clock::now(); }
 
-  _actorsToClear.insert(a);
+inline void FramePacer::FrameDone() {
+  Clock::time_point now = Clock::now();
 
-  if (std::is_base_of<Ticking, T>::value)
-    _handle_TICKING.insert((Ticking *)(a));
+  _frameTimes[_cursor] =
+      std::chrono::duration<float, std::milli>(now - _lastFrame).count();
+  _latencies[_cursor] =
+      std::chrono::duration<float, std::milli>(now - _inputAt).count();
+  _lastFrame = now;
 
-  if (std::is_base_of<Transform2D, T>::value)
-    _handle_TRANSFORMABLE.insert((Transform2D *)(a));
+  _cursor = (_cursor + 1) % FRAME_STATS_SAMPLES;
+  if (_count < FRAME_STATS_SAMPLES)
+    _count++;
+}
 
-  ((Actor *)a)->OnStageEnter(_play);
+inline FrameStats FramePacer::FrameTimes() const {
+  return stats(_frameTimes, _count);
 }
 
-/** @brief Will remove an Actor from the stage, on the start of the next Cycle
- *
- * @param a - the actor to remove
- */
-template <typename T> inline void Stage::RemoveActor(T *a) {
-  static_assert(std::is_base_of<Actor, T>::value,
-                "Cant call RemoveActor with none Actors");
+inline FrameStats FramePacer::Latencies() const {
+  return stats(_latencies, _count);
+}
 
-  if (_sceneUnloading)
-    ClearActorFromStage(a);
-  else {
-    a->_attributes.insert(DEAD);
-    _handle_DEAD.insert(a);
-  }
+inline FrameStats FramePacer::stats(const std::vector<float> &samples,
+                                    unsigned int count) {
+  FrameStats fs;
+  fs.samples = count;
+  if (count == 0)
+    return fs;
+
+  std::vector<float> sorted(samples.begin(), samples.begin() + count);
+  std::sort(sorted.begin(), sorted.end());
+
+  fs.p50 = sorted[(count - 1) * 50 / 100];
+  fs.p95 = sorted[(count - 1) * 95 / 100];
+  fs.p99 = sorted[(count - 1) * 99 / 100];
+  fs.max = sorted[count - 1];
+  return fs;
 }
 
-/** @brief Activates the Rendinger of the actor on the stage
- *
- * Can only execute, when not rendering.
- *
- * @tparam T  - Any Class extending Theater::Actor and Theater::Visible
- * @param actor - an instance of the A Class extending Theater::Actor and
- * Theater::Visible
- * @return true = Actor is now visible ; false = limit of visible actors
- * reached or you tried to change an actors visibility during rendering.
- */
-template <typename T> inline bool Stage::MakeActorVisible(T *actor) {
-  if (this->_rendering)
-    return false;
+// BM: FrameArena - Implementation
+//==============================================================================
+inline FrameArena::FrameArena(size_t capacity)
+    : _block(new char[capacity]), _capacity(capacity), _offset(0),
+      _overflow(), _overflowSize(0), _overflowOffset(0), _used(0) {}
 
-  // Make sure the given Object supports the right classes
-  static_assert(
-      std::is_base_of<Actor, T>::value,
-      "Can't make a class visible, that does not implement Theater::Actor");
+inline char *FrameArena::alignUp(char *p, size_t align) {
+  uintptr_t at = reinterpret_cast<uintptr_t>(p);
+  return p + ((align - at % align) % align);
+}
 
-  static_assert(
-      std::is_base_of<Visible, T>::value,
-      "Can't make a class visible, that does not implement Theater::Visible");
+inline void *FrameArena::Allocate(size_t size, size_t align) {
+  char *at = alignUp(_block.get() + _offset, align);
+  size_t end = (at - _block.get()) + size;
+  if (end > _capacity)
+    return overflow(size, align);
 
-  // Should there be no free slots anymore, do nothing and fail
-  if (_renderNodeCnt == ACTORLIMIT)
-    return false;
+  _used += end - _offset;
+  _offset = end;
+  return at;
+}
 
-  // Otherwise set the splot tho the new object
-  _renderNodes[_renderNodeCnt].obj = (Visible *)actor;
-  _renderNodes[_renderNodeCnt].alive = true;
-  _renderNodes[_renderNodeCnt].next = NULL;
-  _renderNodes[_renderNodeCnt].prev = NULL;
-  ((Visible *)actor)->_renderListIndex = _renderNodeCnt;
-  _renderNodeCnt++;
+template <typename T, typename... Args>
+T *FrameArena::Make(Args &&...args) {
+  return new (Allocate(sizeof(T), alignof(T)))
+      T(std::forward<Args>(args)...);
+}
 
-  // Give the Actor the "Visible" Attribute
-  ((Actor *)actor)->_attributes.insert(VISIBLE);
+inline void *FrameArena::overflow(size_t size, size_t align) {
+  if (!_overflow.empty()) {
+    char *base = _overflow.back().get();
+    char *at = alignUp(base + _overflowOffset, align);
+    size_t end = (at - base) + size;
+    if (end <= _overflowSize) {
+      _used += end - _overflowOffset;
+      _overflowOffset = end;
+      return at;
+    }
+  }
 
-  // Return successfully
-  return true;
+  _overflowSize = std::max(_capacity, size + align);
+  _overflow.emplace_back(new char[_overflowSize]);
+  char *base = _overflow.back().get();
+  char *at = alignUp(base, align);
+  _overflowOffset = (at - base) + size;
+  _used += _overflowOffset;
+  return at;
 }
 
-template <typename T> inline void Stage::MakeActorInvisible(T *actor) {
-  if (this->_rendering)
-    return;
+inline void FrameArena::Reset() {
+  // Ran out this time: grow, so the same frame fits into one block next time
+  if (!_overflow.empty()) {
+    _capacity = std::max(_capacity * 2, _used + _used / 4);
+    _block.reset(new char[_capacity]);
+    _overflow.clear();
+    _overflowSize = 0;
+    _overflowOffset = 0;
+  }
 
-  // make sure the given Object has the right Classes
-  static_assert(
-      std::is_base_of<Visible, T>::value,
-      "Can't make a class visible, that does not implement Theater::Visible");
+  _offset = 0;
+  _used = 0;
+}
 
-  // If there is no Objects to remove, do nothing
-  if (_renderNodeCnt == 0)
-    return;
+inline size_t FrameArena::Used() const { return _used; }
 
-  // If there is no Objects to remove, do nothing
-  Visible *vis = (Visible *)actor;
-  if (std::is_base_of<Actor, T>::value) {
-    ((Actor *)actor)->_attributes.erase(VISIBLE);
-  }
+inline size_t FrameArena::Capacity() const { return _capacity; }
 
-  // if the objects _renderListIndex is -1 -> do nothing
-  if (vis->_renderListIndex == -1)
-    return;
+// BM: AllocationTracker - Implementation
+//==============================================================================
+inline AllocationTracker::AllocationTracker()
+    : _hooked(false), _phase(PHASE_NONE), _frame(), _last(), _total(),
+      _lastArenaBytes(0) {}
 
-  _renderNodeCnt--;
-  // If the removed element is not the last one.
-  if (vis->_renderListIndex != _renderNodeCnt) {
-    // Move the last elements content to the slot of the element to remove
-    _renderNodes[vis->_renderListIndex].obj = _renderNodes[_renderNodeCnt].obj;
+inline AllocationTracker &AllocationTracker::Get() {
+  static AllocationTracker tracker;
+  return tracker;
+}
 
-    _renderNodes[vis->_renderListIndex].alive =
-        _renderNodes[_renderNodeCnt].alive;
-    _renderNodes[vis->_renderListIndex].next =
-        _renderNodes[_renderNodeCnt].next;
-    _renderNodes[vis->_renderListIndex].prev =
-        _renderNodes[_renderNodeCnt].prev;
+inline bool &AllocationTracker::trackedThread() {
+  static thread_local bool tracked = false;
+  return tracked;
+}
 
-    _renderNodes[vis->_renderListIndex].obj->_renderListIndex =
-        vis->_renderListIndex;
-  }
+inline bool AllocationTracker::Hooked() const { return _hooked; }
 
-  // Then remove the last Slot
-  _renderNodes[_renderNodeCnt].obj = NULL;
-  _renderNodes[_renderNodeCnt].alive = false;
-  _renderNodes[_renderNodeCnt].next = NULL;
-  _renderNodes[_renderNodeCnt].prev = NULL;
+inline AllocationCounts AllocationTracker::LastFrame(FramePhase phase) const {
+  return _last[phase];
 }
 
-inline bool Stage::AddActorAttribute(Actor *act, Attributes attr) {
-  if (_actorsToClear.find(act) == _actorsToClear.end()) {
-    return false;
+inline AllocationCounts AllocationTracker::LastFrame() const {
+  AllocationCounts sum;
+  for (const AllocationCounts &c : _last) {
+    sum.allocations += c.allocations;
+    sum.frees += c.frees;
+    sum.bytes += c.bytes;
   }
+  return sum;
+}
 
-  switch (attr) {
-  case DEAD:
-    std::cout << " Can't assign ActorAttribute 'DEAD' via "
-                 "Stage::AddActorAttribute => use Stage::RemoveActor instead"
-              << std::endl;
-    return false;
-
-  case TICKING:
-    std::cout
-        << " Can't assign Internal Attribute 'TICKING' via AddActorAttribute "
-           "The Actors class must instead inherit from Theater::Ticking"
-        << std::endl;
-    return false;
-
-  case VISIBLE:
-    std::cout
-        << " Can't assign Internal Attribute 'VISIBLE' via AddActorAttribute "
-           "The Actors class must instead inherit from Theater::Visible"
-        << std::endl;
-    return false;
+inline AllocationCounts AllocationTracker::Total(FramePhase phase) const {
+  return _total[phase];
+}
 
-  case TRANSFORMABLE:
-    std::cout
-        << " Can't assign Internal Attribute 'TRANSFORMABLE' via "
-           "AddActorAttribute "
-           "The Actors class must instead inherit from Theater::Transform2D"
-        << std::endl;
+inline size_t AllocationTracker::LastFrameArenaBytes() const {
+  return _lastArenaBytes;
+}
 
-    return false;
+inline const char *AllocationTracker::PhaseName(FramePhase phase) {
+  static const char *names[__PHASE_COUNT] = {"none", "scene", "input", "tick",
+                                             "draw"};
+  return phase < __PHASE_COUNT ? names[phase] : "?";
+}
 
-#define STAGE_ATTRIBUTE(name)                                                  \
-  case name:                                                                   \
-    _handle_##name.insert(act);                                                \
-    act->_attributes.insert(attr);                                             \
-    return true;
-#if __has_include("RayTheaterAttributes.hpp")
-#include "RayTheaterAttributes.hpp"
-#endif // __has_include("RayTheaterAttributes.hpp")
-#undef STAGE_ATTRIBUTE
+inline void AllocationTracker::TrackThisThread() { trackedThread() = true; }
 
-  default:
-    return false;
-  }
+inline void AllocationTracker::BeginFrame() {
+  for (AllocationCounts &c : _frame)
+    c = AllocationCounts();
+  _phase = PHASE_SCENE;
 }
 
-inline bool Stage::RemoveActorAttribute(Actor *act, Attributes attr) {
-
-  if (_actorsToClear.find(act) == _actorsToClear.end()) {
-    return false;
-  }
+inline void AllocationTracker::Phase(FramePhase phase) { _phase = phase; }
 
-  switch (attr) {
-  case DEAD:
-    std::cout << " Can't remove ActorAttribute 'DEAD' via "
-                 "Stage::RemoveActorAttribute"
-              << std::endl;
-    return false;
+inline void AllocationTracker::EndFrame(size_t arenaBytes) {
+  for (int a = 0; a < __PHASE_COUNT; a++)
+    _last[a] = _frame[a];
+  _lastArenaBytes = arenaBytes;
+  _phase = PHASE_NONE;
+}
 
-  case TICKING:
-    std::cout << " Can't remove Internal Attribute 'TICKING' via "
-                 "RemoveActorAttribute "
-              << std::endl;
-    return false;
+inline void AllocationTracker::Hook() { _hooked = true; }
 
-  case VISIBLE:
-    std::cout << " Can't remove Internal Attribute 'VISIBLE' via "
-                 "RemoveActorAttribute "
-              << std::endl;
-    return false;
+inline void AllocationTracker::Allocated(size_t bytes) {
+  if (!trackedThread())
+    return;
 
-  case TRANSFORMABLE:
-    std::cout << " Can't remove Internal Attribute 'TRANSFORMABLE' via "
-                 "RemoveActorAttribute "
-              << std::endl;
-    return false;
+  _frame[_phase].allocations++;
+  _frame[_phase].bytes += bytes;
+  _total[_phase].allocations++;
+  _total[_phase].bytes += bytes;
+}
 
-#define STAGE_ATTRIBUTE(name)                                                  \
-  case name:                                                                   \
-    _handle_##name.erase(act);                                                 \
-    act->_attributes.erase(attr);                                              \
-    return true;
-#if __has_include("RayTheaterAttributes.hpp")
-#include "RayTheaterAttributes.hpp"
-#endif // __has_include("RayTheaterAttributes.hpp")
-#undef STAGE_ATTRIBUTE
+inline void AllocationTracker::Freed() {
+  if (!trackedThread())
+    return;
 
-  default:
-    return false;
-  }
+  _frame[_phase].frees++;
+  _total[_phase].frees++;
 }
 
-inline void Stage::ClearStage() {
-
-  for (Actor *a : _actorsToClear)
-    a->OnStageLeave(_play);
+// BM: Stage - Implementation - Snapshots
+//==============================================================================
+inline void Stage::SaveSnapshot(std::vector<unsigned char> &buffer) {
+  static_assert(__STAGE_ATTRIBUTE_COUNT <= 64,
+                "Snapshots support up to 64 Attributes");
+
+  buffer.clear();
+  SnapshotWriter w(&buffer);
+
+  SnapshotHeader header = {{'R', 'T', 'S', 'S'},
+                           RAYTHEATER_SNAPSHOT_VERSION,
+                           0,
+                           (unsigned int)_ensemble->actors.size(),
+                           _tickingPaused ? SNAPSHOT_PAUSED : 0u};
+  w.Write(header);
+
+  for (StageActor &sa : _ensemble->actors) {
+    size_t start = buffer.size();
+
+    SnapshotActorRecord rec = {};
+    rec.components = (sa.ticking != NULL ? SNAPSHOT_TICKING : 0) |
+                     (sa.transform != NULL ? SNAPSHOT_TRANSFORM2D : 0) |
+                     (sa.visible != NULL ? SNAPSHOT_VISIBLE : 0);
+    rec.handleIndex = sa.handleSlot;
+    rec.handleGeneration = _actorSlots[sa.handleSlot].generation;
+
+    for (Attributes attr : sa.actor->_attributes)
+      rec.attributes |= 1ull << attr;
+
+    if (sa.visible != NULL) {
+      rec.zindex = sa.visible->_zindex;
+      rec.visible = sa.visible->_renderListIndex != -1 ? 1 : 0;
+    }
 
-  _actorsToClear.clear();
+    if (sa.transform != NULL) {
+      rec.loc = sa.transform->getLoc();
+      rec.nextLoc = sa.transform->getNextLoc();
+      rec.rotation = sa.transform->getRotation();
+      rec.nextRotation = sa.transform->getNextRotation();
+      rec.scale = sa.transform->getScale();
+      rec.nextScale = sa.transform->getNextScale();
+    }
 
-#define STAGE_ATTRIBUTE(name) _handle_##name.clear();
-  STAGE_ATTRIBUTE(DEAD)
-  STAGE_ATTRIBUTE(TICKING)
-  STAGE_ATTRIBUTE(TRANSFORMABLE)
-  STAGE_ATTRIBUTE(VISIBLE)
+    w.Write(rec);
+    sa.actor->OnSnapshotSave(w);
 
-#if __has_include("RayTheaterAttributes.hpp")
-#include "RayTheaterAttributes.hpp"
-#endif // __has_include("RayTheaterAttributes.hpp")
-#undef STAGE_ATTRIBUTE
+    unsigned int size = buffer.size() - start;
+    memcpy(buffer.data() + start, &size, sizeof(size));
 
-  for (int a = 0; a < ACTORLIMIT; a++) {
-    _renderNodes[a].obj = NULL;
-    _renderNodes[a].next = NULL;
-    _renderNodes[a].prev = NULL;
-    _renderNodes[a].alive = false;
-    _renderNodes[a].index = 0;
+    // Keep each record 4 byte aligned
+    while ((buffer.size() - start) & 3)
+      buffer.push_back(0);
   }
 
-  _renderNodeCnt = 0;
+  header.size = buffer.size();
+  memcpy(buffer.data(), &header, sizeof(header));
 }
 
-template <typename T> inline void Stage::ClearActorFromStage(T *a) {
+inline bool Stage::LoadSnapshot(const unsigned char *data, size_t size) {
+  SnapshotHeader header;
+  SnapshotActorRecord rec;
+
+  if (data == NULL || size < sizeof(header))
+    return false;
+
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, "RTSS", 4) != 0 ||
+      header.version != RAYTHEATER_SNAPSHOT_VERSION || header.size > size ||
+      header.actorCount != _ensemble->actors.size())
+    return false;
 
-  if (std::is_base_of<Actor, T>::value) {
-    ((Actor *)a)->OnStageLeave(_play);
-    _actorsToClear.erase(a);
+  // First make sure the snapshot fits the Actors on Stage, before changing
+  // anything. Removing Actors reorders the others, so each record is
+  // matched to its Actor by the handle. A removed and re-added Actor has a
+  // new handle, and does not match anymore.
+  std::vector<unsigned int> targets(header.actorCount);
+  std::vector<bool> matched(header.actorCount, false);
+  size_t pos = sizeof(header);
+  for (unsigned int a = 0; a < header.actorCount; a++) {
+    if (pos + sizeof(rec) > header.size)
+      return false;
+
+    memcpy(&rec, data + pos, sizeof(rec));
+    StageActor *sa =
+        stageActor(ActorHandle(rec.handleIndex, rec.handleGeneration));
+    if (sa == NULL || matched[sa->actor->_stageIndex])
+      return false;
+
+    unsigned int components =
+        (sa->ticking != NULL ? SNAPSHOT_TICKING : 0) |
+        (sa->transform != NULL ? SNAPSHOT_TRANSFORM2D : 0) |
+        (sa->visible != NULL ? SNAPSHOT_VISIBLE : 0);
+
+    size_t padded = (rec.size + 3u) & ~(size_t)3;
+    if (rec.size < sizeof(rec) || pos + padded > header.size ||
+        rec.components != components)
+      return false;
+
+    targets[a] = sa->actor->_stageIndex;
+    matched[targets[a]] = true;
+    pos += padded;
   }
 
-  if (std::is_base_of<Ticking, T>::value) {
-    auto fndTick = _handle_TICKING.find((Ticking *)a);
-    if (fndTick != _handle_TICKING.end()) {
-      _handle_TICKING.erase(fndTick);
+  pos = sizeof(header);
+  for (unsigned int a = 0; a < header.actorCount; a++) {
+    memcpy(&rec, data + pos, sizeof(rec));
+    StageActor &sa = _ensemble->actors[targets[a]];
+    Actor *act = sa.actor;
+
+    if (sa.transform != NULL) {
+      TransformStore &ts = _ensemble->transforms;
+      unsigned int i = sa.transform->_storeIndex;
+      ts.x[i] = rec.loc.x;
+      ts.y[i] = rec.loc.y;
+      ts.rotation[i] = rec.rotation;
+      ts.scale[i] = rec.scale;
+      ts.nextX[i] = rec.nextLoc.x;
+      ts.nextY[i] = rec.nextLoc.y;
+      ts.nextRotation[i] = rec.nextRotation;
+      ts.nextScale[i] = rec.nextScale;
+
+      // World values follow with the next flip
+      ts.MarkDirty(i);
     }
-  }
 
-  if (std::is_base_of<Transform2D, T>::value) {
-    auto fndTrns2D = _handle_TRANSFORMABLE.find((Transform2D *)a);
-    if (fndTrns2D != _handle_TRANSFORMABLE.end()) {
-      _handle_TRANSFORMABLE.erase(fndTrns2D);
+    if (sa.visible != NULL) {
+      sa.visible->_zindex = rec.zindex;
+      if (rec.visible)
+        showActor(act, sa.visible);
+      else if (sa.visible->_renderListIndex != -1)
+        hideActor(act, sa.visible);
     }
-  }
 
-  if (std::is_base_of<Visible, T>::value) {
-    auto actorVis = a->_attributes.find(VISIBLE);
-    if (actorVis != a->_attributes.end()) {
-      MakeActorInvisible((Visible *)a);
+    if (rec.attributes & (1ull << DEAD)) {
+      act->_attributes.insert(DEAD);
+      _ensemble->handle_DEAD.insert(act);
+    } else if (act->hasAttribute(DEAD)) {
+      act->_attributes.erase(DEAD);
+      _ensemble->handle_DEAD.erase(act);
     }
-  }
 
 #define STAGE_ATTRIBUTE(name)                                                  \
-  auto act_##name = _handle_##name.find(a);                                    \
-  if (act_##name != _handle_##name.end()) {                                    \
-    _handle_##name.erase(act_##name);                                          \
+  if (rec.attributes & (1ull << name)) {                                       \
+    act->_attributes.insert(name);                                             \
+    _ensemble->handle_##name.insert(act);                                      \
+  } else if (act->hasAttribute(name)) {                                        \
+    act->_attributes.erase(name);                                              \
+    _ensemble->handle_##name.erase(act);                                       \
   }
-
-  STAGE_ATTRIBUTE(DEAD)
-
 #if __has_include("RayTheaterAttributes.hpp")
 #include "RayTheaterAttributes.hpp"
 #endif // __has_include("RayTheaterAttributes.hpp")
-  STAGE_ATTRIBUTE(VISIBLE)
 #undef STAGE_ATTRIBUTE
+
+    SnapshotReader reader(data + pos + sizeof(rec), rec.size - sizeof(rec));
+    act->OnSnapshotLoad(reader);
+
+    pos += (rec.size + 3u) & ~(size_t)3;
+  }
+
+  _tickingPaused = (header.flags & SNAPSHOT_PAUSED) != 0;
+  return true;
 }
 
-inline std::unordered_set<Actor *>
-Stage::GetActorsWithAttribute(Attributes attr) {
-  switch (attr) {
-  case TICKING:
-  case TRANSFORMABLE:
-  case VISIBLE:
-  case DEAD:
-    std::cerr << "can't request Actors for Internal Attributes" << std::endl;
-  default:
-    return std::unordered_set<Actor *>();
+// BM: Snapshot - Implementation
+//==============================================================================
+inline void SnapshotWriter::WriteBytes(const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  _buffer->insert(_buffer->end(), bytes, bytes + size);
+}
 
-#define STAGE_ATTRIBUTE(name)                                                  \
-  case name:                                                                   \
-    return _handle_##name;
+inline void SnapshotWriter::Write(const CountdownTimer &t) {
+  Write(t.m_TargetTime);
+  Write(t.m_TimerValue);
+  Write(t.m_ProgressResolution);
+  Write(t.m_NextProgress);
+}
 
-#if __has_include("RayTheaterAttributes.hpp")
-#include "RayTheaterAttributes.hpp"
-#endif
-#undef STAGE_ATTRIBUTE
-  }
+inline bool SnapshotReader::ReadBytes(void *data, size_t size) {
+  if (size > _size - _pos)
+    return false;
+
+  memcpy(data, _data + _pos, size);
+  _pos += size;
+  return true;
+}
+
+inline bool SnapshotReader::Read(CountdownTimer &t) {
+  return Read(t.m_TargetTime) && Read(t.m_TimerValue) &&
+         Read(t.m_ProgressResolution) && Read(t.m_NextProgress);
 }
 
 // BM: Timer - Implementation
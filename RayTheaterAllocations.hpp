@@ -0,0 +1,89 @@
+#ifndef RayTheaterAllocations_H
+#define RayTheaterAllocations_H 1
+
+#include <cstdlib>
+#include <new>
+
+#include "RayTheater.hpp"
+
+// Replaces the global operator new and delete, so the AllocationTracker can
+// count the heap allocations of each Stage cycle. Include this header in
+// exactly ONE translation unit. The hooks are only built in debug builds
+// (-DDEBUG) or with STAGE_TRACK_ALLOCATIONS defined.
+#if defined(DEBUG) || defined(STAGE_TRACK_ALLOCATIONS)
+
+namespace Theater {
+namespace AllocationHooks {
+
+inline void *allocate(size_t size) {
+  AllocationTracker::Get().Allocated(size);
+  return std::malloc(size != 0 ? size : 1);
+}
+
+inline void release(void *ptr) {
+  if (ptr == NULL)
+    return;
+
+  AllocationTracker::Get().Freed();
+  std::free(ptr);
+}
+
+// Tells the tracker, that it is counting, before main starts
+static const bool installed = (AllocationTracker::Get().Hook(), true);
+
+} // namespace AllocationHooks
+} // namespace Theater
+
+// BM: AllocationHooks - Implementation
+//==============================================================================
+void *operator new(size_t size) {
+  void *ptr = Theater::AllocationHooks::allocate(size);
+  if (ptr == NULL)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  void *ptr = Theater::AllocationHooks::allocate(size);
+  if (ptr == NULL)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return Theater::AllocationHooks::allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return Theater::AllocationHooks::allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+  Theater::AllocationHooks::release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  Theater::AllocationHooks::release(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  Theater::AllocationHooks::release(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  Theater::AllocationHooks::release(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void *ptr, size_t) noexcept {
+  Theater::AllocationHooks::release(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  Theater::AllocationHooks::release(ptr);
+}
+#endif // defined(__cpp_sized_deallocation)
+
+#endif // defined(DEBUG) || defined(STAGE_TRACK_ALLOCATIONS)
+
+#endif // RayTheaterAllocations_H
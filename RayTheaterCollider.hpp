@@ -1,19 +1,39 @@
 #ifndef RayTheaterCollider_H
 #define RayTheaterCollider_H 1
 
+#include <algorithm>
+#include <cmath>
 #include <raylib.h>
+#include <unordered_map>
 #include <vector>
 
 namespace Theater {
 
+// Width and height of a ColliderGrid cell in pixels (default)
+#ifndef COLLIDER_GRID_CELL
+#define COLLIDER_GRID_CELL 64
+#endif
+
 // BM: Collider - Class
 //==============================================================================
 class ColliderPoint;
 class ColliderCircle;
 class ColliderRect;
 class ColliderZone;
+class ColliderGrid;
+struct RayHit;
 
 class Collider {
+  friend class ColliderGrid;
+  friend class ColliderPoint;
+  friend class ColliderCircle;
+  friend class ColliderRect;
+  friend class ColliderZone;
+
+  // Layers, this Collider is on, and layers, it collides with
+  unsigned int _layer = 1;
+  unsigned int _mask = ~0u;
+
   virtual bool isCollidingWithPoint(ColliderPoint *) = 0;
   virtual bool isCollidingWithRect(ColliderRect *) = 0;
   virtual bool isCollidingWithCircle(ColliderCircle *) = 0;
@@ -21,25 +41,60 @@ class Collider {
 
   virtual bool containsPoint(float x, float y) = 0;
 
+  /** @return the box around the shape, used to sort it into a ColliderGrid */
+  virtual Rectangle getBounds() = 0;
+
+  /** @brief intersects the ray origin + dir * t (dir of length 1, t from 0
+   * to maxDist) with the shape. Fills distance, point and normal of the
+   * first hit. A ray, that starts inside the shape, hits at distance 0 */
+  virtual bool castRay(Vector2 origin, Vector2 dir, float maxDist,
+                       RayHit *hit) = 0;
+
+  /** @brief tests other against this shape, by calling others
+   * isCollidingWith... for this shape */
+  virtual bool collide(Collider *other) = 0;
+
 public:
+  /** @brief sets the layers (bits), this Collider is on (default 1) */
+  void setCollisionLayer(unsigned int bits) { _layer = bits; }
+  unsigned int getCollisionLayer() { return _layer; }
+
+  /** @brief sets the layers (bits), this Collider collides with (default all)
+   */
+  void setCollisionMask(unsigned int bits) { _mask = bits; }
+  unsigned int getCollisionMask() { return _mask; }
+
+  /** @brief if the layers allow both Colliders to collide. Checked before any
+   * shape is read */
+  bool canCollideWith(Collider *other) {
+    return (_layer & other->_mask) != 0 && (other->_layer & _mask) != 0;
+  }
+
   static bool zoneContainsPoint(std::vector<Vector2> *zoneborder,
                                 Vector2 point) {
+    return zoneContainsPoint(zoneborder->data(), zoneborder->size(), point);
+  }
+
+  /** @brief same as above, for a border, that is no std::vector (e.g. an
+   * array on the stack, so no heap allocation is needed) */
+  static bool zoneContainsPoint(const Vector2 *zoneborder, size_t count,
+                                Vector2 point) {
 
-    switch (zoneborder->size()) {
+    switch (count) {
     case 0:
       return false;
       break;
 
     case 1:
-      auto dot = zoneborder->at(0);
+      auto dot = zoneborder[0];
       return dot.x == point.x && dot.y == point.y;
       break;
     }
 
-    auto connectDots = [](std::vector<Vector2> *dots, int d1, int d2,
+    auto connectDots = [](const Vector2 *dots, size_t d1, size_t d2,
                           Vector2 point) {
-      auto pos1 = dots->at(d1);
-      auto pos2 = dots->at(d2);
+      auto pos1 = dots[d1];
+      auto pos2 = dots[d2];
 
       unsigned char b1 = ((pos1.y <= point.y ? 1 : 0) << 0) |
                          ((pos1.y > point.y ? 1 : 0) << 1);
@@ -67,10 +122,10 @@ public:
     };
 
     unsigned int intersections = 0;
-    for (int a = 0; a < zoneborder->size() - 1; a++)
+    for (size_t a = 0; a < count - 1; a++)
       intersections += connectDots(zoneborder, a, a + 1, point);
 
-    intersections += connectDots(zoneborder, zoneborder->size() - 1, 0, point);
+    intersections += connectDots(zoneborder, count - 1, 0, point);
 
     return (intersections & 1) == 1;
   }
@@ -93,6 +148,11 @@ public:
 
   bool containsPoint(float x, float y) override;
 
+  Rectangle getBounds() override;
+  bool castRay(Vector2 origin, Vector2 dir, float maxDist,
+               RayHit *hit) override;
+  bool collide(Collider *other) override;
+
 }; // namespace Theater
 
 // BM: Collider - Rect - Class
@@ -113,6 +173,11 @@ public:
   bool rectContainsPoint(Rectangle r, Vector2 p);
   bool containsPoint(float x, float y) override;
 
+  Rectangle getBounds() override;
+  bool castRay(Vector2 origin, Vector2 dir, float maxDist,
+               RayHit *hit) override;
+  bool collide(Collider *other) override;
+
 private:
   bool rectInRect(Rectangle r1, Rectangle r2);
 
@@ -137,6 +202,11 @@ public:
   bool containsPoint(float x, float y) override;
   bool containsPoint(Vector2 p);
 
+  Rectangle getBounds() override;
+  bool castRay(Vector2 origin, Vector2 dir, float maxDist,
+               RayHit *hit) override;
+  bool collide(Collider *other) override;
+
 private:
   bool lineHitsCircle(float cx, float cy, float radius, float x1, float y1,
                       float x2, float y2);
@@ -144,7 +214,7 @@ private:
   bool pointHitsCircle(float cx, float cy, float radius, float px, float py);
 
   bool circleHitsPolyShape(Vector2 circleOrigin, float circleRadius,
-                           std::vector<Vector2> lst);
+                           const Vector2 *lst, size_t count);
 };
 
 // BM: Collider - Zone - Class
@@ -164,9 +234,137 @@ public:
 
   bool containsPoint(float x, float y) override;
 
+  Rectangle getBounds() override;
+  bool castRay(Vector2 origin, Vector2 dir, float maxDist,
+               RayHit *hit) override;
+  bool collide(Collider *other) override;
+
+private:
+  static bool containsOneOfPoints(const Vector2 *shape, size_t shapeCount,
+                                  const Vector2 *points, size_t count);
+};
+
+// BM: ColliderGrid - Class
+//==============================================================================
+/** @brief where a ray hit a Collider */
+struct RayHit {
+  Collider *collider = nullptr;
+
+  /** @brief pixels from the rays origin to point */
+  float distance = 0;
+  Vector2 point = {0, 0};
+
+  /** @brief unit vector, pointing out of the surface, that was hit */
+  Vector2 normal = {0, 0};
+};
+
+/** @brief a ray for batched casts. direction doesn't need to be normalized */
+struct Ray2D {
+  Vector2 origin;
+  Vector2 direction;
+  float maxDistance;
+};
+
+/** @brief Sorts Colliders into a uniform grid of cells, so ray and segment
+ * casts only test the Colliders in the cells they cross (DDA), instead of
+ * every Collider.
+ *
+ * The grid doesn't watch its Colliders. Once one moves, changes its shape or
+ * its collision layers, call Moved (or Refresh for all of them).
+ *
+ * Every query takes layers into account (see Collider::setCollisionLayer),
+ * before it reads a shape.
+ */
+class ColliderGrid {
+public:
+  ColliderGrid(float cellSize = COLLIDER_GRID_CELL);
+
+  void Add(Collider *c);
+  void Remove(Collider *c);
+
+  /** @brief sorts c into the cells of its current shape again */
+  void Moved(Collider *c);
+
+  /** @brief sorts all Colliders into their cells again */
+  void Refresh();
+
+  void Clear();
+
+  /** @return number of Colliders in the grid */
+  unsigned int Count();
+
+  /** @brief finds the closest Collider along the ray
+   * @param maxDistance - in pixels (INFINITY = as far as there are Colliders)
+   * @param mask - layers, the ray can hit
+   * @return if something was hit (hit is only written then) */
+  bool Raycast(Vector2 origin, Vector2 direction, float maxDistance,
+               RayHit *hit, unsigned int mask = ~0u);
+
+  /** @brief finds the Collider closest to from, between from and to */
+  bool SegmentCast(Vector2 from, Vector2 to, RayHit *hit,
+                   unsigned int mask = ~0u);
+
+  /** @return every Collider along the ray, closest first */
+  std::vector<RayHit> RaycastAll(Vector2 origin, Vector2 direction,
+                                 float maxDistance, unsigned int mask = ~0u);
+
+  std::vector<RayHit> SegmentCastAll(Vector2 from, Vector2 to,
+                                     unsigned int mask = ~0u);
+
+  /** @brief casts many rays at once (e.g. the view cone of an AI) and writes
+   * the closest hit of rays[a] to hits[a] (collider = nullptr on a miss) */
+  void Raycast(const std::vector<Ray2D> &rays, std::vector<RayHit> &hits,
+               unsigned int mask = ~0u);
+
+  /** @brief calls fn(a, b) once for each pair of Colliders in the grid, that
+   * collide. Pairs, whose layers don't match, are skipped first, then pairs,
+   * whose bounds don't touch. fn must not change the grid */
+  template <typename Fn> void ForEachCollidingPair(Fn fn);
+
+  /** @brief calls fn(other) for each Collider in the grid, that collides with
+   * c (c doesn't need to be in the grid) */
+  template <typename Fn> void ForEachCollidingWith(Collider *c, Fn fn);
+
 private:
-  bool containsOneOfPoints(std::vector<Vector2> *shape,
-                           std::vector<Vector2> points);
+  struct Entry {
+    Collider *collider;
+    unsigned int layer; // copies of the Colliders layers, so pairs are
+    unsigned int mask;  // rejected without touching the Collider
+    Rectangle bounds;
+    int x0, y0, x1, y1; // cells, the Collider was sorted into
+    unsigned int stamp; // last query, that tested it
+  };
+
+  float _cellSize;
+  std::vector<Entry> _entries;
+  std::vector<unsigned int> _free;
+  std::unordered_map<Collider *, unsigned int> _index;
+  std::unordered_map<long long, std::vector<unsigned int>> _cells;
+  unsigned int _stamp;
+
+  // Cells, that contain (or once contained) Colliders
+  int _minX, _minY, _maxX, _maxY;
+
+  // Helpers
+  //----------------------------------------------------------------------------
+  static long long cellKey(int x, int y);
+  static bool boundsTouch(Rectangle a, Rectangle b);
+  int cellOf(float v);
+  unsigned int nextStamp();
+  void insert(unsigned int e);
+  void erase(unsigned int e);
+
+  /** @brief walks the cells along the ray, calls hitFn for every Collider,
+   * that is hit. Stops early, once hitFn returns a distance, no later cell
+   * can undercut */
+  template <typename Fn>
+  void traverse(Vector2 origin, Vector2 dir, float maxDist, unsigned int mask,
+                Fn hitFn);
+
+  bool castClosest(Vector2 origin, Vector2 dir, float maxDist,
+                   unsigned int mask, RayHit *hit);
+  std::vector<RayHit> castAll(Vector2 origin, Vector2 dir, float maxDist,
+                              unsigned int mask);
 };
 
 // BM: Collider - Circle - Implementation
@@ -177,7 +375,7 @@ inline bool ColliderCircle::pointHitsCircle(float cx, float cy, float rad,
   auto dstx1 = abs(cx - px);
   auto dsty1 = abs(cy - py);
 
-  return dstx1 * dstx1 + dsty1 * dsty1 > rad2;
+  return dstx1 * dstx1 + dsty1 * dsty1 <= rad2;
 }
 
 inline bool ColliderCircle::containsPoint(float x, float y) {
@@ -212,11 +410,12 @@ inline bool ColliderCircle::lineHitsCircle(float cx, float cy, float cr,
 
 inline bool ColliderCircle::circleHitsPolyShape(Vector2 circleOrigin,
                                                 float circleRadius,
-                                                std::vector<Vector2> lst) {
+                                                const Vector2 *lst,
+                                                size_t count) {
   bool hit = false;
-  for (auto a = 0; a < lst.size() - 1; a++) {
-    auto s = lst.at(a);
-    auto e = lst.at(a + 1);
+  for (size_t a = 0; a + 1 < count; a++) {
+    auto s = lst[a];
+    auto e = lst[a + 1];
     hit = hit || this->lineHitsCircle(circleOrigin.x, circleOrigin.y,
                                       circleRadius, s.x, s.y, e.x, e.y);
   }
@@ -237,10 +436,16 @@ inline bool ColliderCircle::containsPoint(Vector2 p) {
 }
 
 inline bool ColliderCircle::isCollidingWithPoint(ColliderPoint *p) {
+  if (!canCollideWith(p))
+    return false;
+
   return containsPoint(p->getPosition());
 }
 
 inline bool ColliderCircle::isCollidingWithCircle(ColliderCircle *c) {
+  if (!canCollideWith(c))
+    return false;
+
   auto rad = this->getRadius() + c->getRadius();
   auto rad2 = rad * rad;
 
@@ -250,39 +455,90 @@ inline bool ColliderCircle::isCollidingWithCircle(ColliderCircle *c) {
   auto dstx1 = abs(pc.x - p.x);
   auto dsty1 = abs(pc.y - p.y);
 
-  return dstx1 * dstx1 + dsty1 * dsty1 > rad2;
+  return dstx1 * dstx1 + dsty1 * dsty1 <= rad2;
 }
 
 inline bool ColliderCircle::isCollidingWithRect(ColliderRect *rc) {
+  if (!canCollideWith(rc))
+    return false;
+
   auto o = this->getPosition();
   auto r = rc->getRect();
   auto rad = this->getRadius();
 
+  Vector2 edges[5] = {{r.x, r.y},
+                      {r.x + r.width, r.y},
+                      {r.x + r.width, r.y + r.height},
+                      {r.x, r.y + r.height},
+                      {r.x, r.y}};
+
   return rc->rectContainsPoint(r, o) ||
-         circleHitsPolyShape(o, rad,
-                             {{r.x, r.y},
-                              {r.x + r.width, r.y},
-                              {r.x + r.width, r.y + r.height},
-                              {r.x, r.y + r.height},
-                              {r.x, r.y}});
+         circleHitsPolyShape(o, rad, edges, 5);
 }
 
 inline bool ColliderCircle::isCollidingWithZone(ColliderZone *z) {
+  if (!canCollideWith(z))
+    return false;
+
   auto zoneShape = z->getZoneBorder();
   auto circPos = getPosition();
   auto circRad = getRadius();
 
   return z->containsPoint(circPos.x, circPos.y) ||
-         circleHitsPolyShape(circPos, circRad, *zoneShape);
+         circleHitsPolyShape(circPos, circRad, zoneShape->data(),
+                             zoneShape->size());
+}
+
+inline Rectangle ColliderCircle::getBounds() {
+  auto p = getPosition();
+  auto r = getRadius();
+  return {p.x - r, p.y - r, r * 2, r * 2};
+}
+
+inline bool ColliderCircle::castRay(Vector2 origin, Vector2 dir, float maxDist,
+                                    RayHit *hit) {
+  auto c = getPosition();
+  auto rad = getRadius();
+
+  float fx = origin.x - c.x;
+  float fy = origin.y - c.y;
+  float b = fx * dir.x + fy * dir.y;
+  float cc = fx * fx + fy * fy - rad * rad;
+
+  if (cc <= 0) {
+    hit->distance = 0;
+    hit->point = origin;
+    hit->normal = {-dir.x, -dir.y};
+    return true;
+  }
+
+  float disc = b * b - cc;
+  if (disc < 0)
+    return false;
+
+  float t = -b - std::sqrt(disc);
+  if (t < 0 || t > maxDist)
+    return false;
+
+  hit->distance = t;
+  hit->point = {origin.x + dir.x * t, origin.y + dir.y * t};
+  hit->normal = {(hit->point.x - c.x) / rad, (hit->point.y - c.y) / rad};
+  return true;
+}
+
+inline bool ColliderCircle::collide(Collider *other) {
+  return other->isCollidingWithCircle(this);
 }
 
 //==============================================================================
 // BM: Collider - Zone - Implementation
 //==============================================================================
-inline bool ColliderZone::containsOneOfPoints(std::vector<Vector2> *shape,
-                                              std::vector<Vector2> points) {
-  for (Vector2 point : points) {
-    if (zoneContainsPoint(shape, point))
+inline bool ColliderZone::containsOneOfPoints(const Vector2 *shape,
+                                              size_t shapeCount,
+                                              const Vector2 *points,
+                                              size_t count) {
+  for (size_t a = 0; a < count; a++) {
+    if (zoneContainsPoint(shape, shapeCount, points[a]))
       return true;
   }
 
@@ -294,39 +550,130 @@ inline bool ColliderZone::containsPoint(float x, float y) {
 }
 
 inline bool ColliderZone::isCollidingWithPoint(ColliderPoint *p) {
+  if (!canCollideWith(p))
+    return false;
+
   return zoneContainsPoint(getZoneBorder(), p->getPosition());
 }
 
 inline bool ColliderZone::isCollidingWithRect(ColliderRect *r) {
+  if (!canCollideWith(r))
+    return false;
+
   auto rect = r->getRect();
-  auto rectZone =
-      std::vector<Vector2>({{rect.x, rect.y},
-                            {rect.x + rect.width, rect.y},
-                            {rect.x + rect.width, rect.y + rect.height},
-                            {rect.x, rect.y + rect.height}});
+  Vector2 rectZone[4] = {{rect.x, rect.y},
+                         {rect.x + rect.width, rect.y},
+                         {rect.x + rect.width, rect.y + rect.height},
+                         {rect.x, rect.y + rect.height}};
 
   auto shapeZone = getZoneBorder();
 
-  bool ret = containsOneOfPoints(shapeZone, rectZone);
+  bool ret = containsOneOfPoints(shapeZone->data(), shapeZone->size(),
+                                 rectZone, 4);
 
   if (!ret)
-    ret = containsOneOfPoints(&rectZone, *shapeZone);
+    ret = containsOneOfPoints(rectZone, 4, shapeZone->data(),
+                              shapeZone->size());
 
   return ret;
 };
 
 inline bool ColliderZone::isCollidingWithCircle(ColliderCircle *c) {
+  if (!canCollideWith(c))
+    return false;
+
   return c->isCollidingWithZone(this);
 }
 
+inline Rectangle ColliderZone::getBounds() {
+  auto border = getZoneBorder();
+  if (border->empty())
+    return {0, 0, 0, 0};
+
+  Vector2 lo = border->at(0), hi = lo;
+  for (Vector2 p : *border) {
+    lo.x = std::min(lo.x, p.x);
+    lo.y = std::min(lo.y, p.y);
+    hi.x = std::max(hi.x, p.x);
+    hi.y = std::max(hi.y, p.y);
+  }
+
+  return {lo.x, lo.y, hi.x - lo.x, hi.y - lo.y};
+}
+
+inline bool ColliderZone::castRay(Vector2 origin, Vector2 dir, float maxDist,
+                                  RayHit *hit) {
+  auto border = getZoneBorder();
+  size_t count = border->size();
+  if (count == 0)
+    return false;
+
+  if (zoneContainsPoint(border, origin)) {
+    hit->distance = 0;
+    hit->point = origin;
+    hit->normal = {-dir.x, -dir.y};
+    return true;
+  }
+
+  // Closest crossing of the ray with one of the borders lines
+  float best = maxDist;
+  bool found = false;
+  Vector2 normal = {0, 0};
+
+  for (size_t a = 0; a < count; a++) {
+    Vector2 p1 = (*border)[a];
+    Vector2 p2 = (*border)[(a + 1) % count];
+
+    float ex = p2.x - p1.x;
+    float ey = p2.y - p1.y;
+    float denom = dir.x * ey - dir.y * ex;
+    if (denom == 0)
+      continue;
+
+    float wx = p1.x - origin.x;
+    float wy = p1.y - origin.y;
+    float t = (wx * ey - wy * ex) / denom;
+    float u = (wx * dir.y - wy * dir.x) / denom;
+
+    if (t < 0 || t > best || u < 0 || u > 1)
+      continue;
+
+    best = t;
+    found = true;
+
+    // Perpendicular to the line, facing against the ray
+    float len = std::sqrt(ex * ex + ey * ey);
+    normal = {-ey / len, ex / len};
+    if (normal.x * dir.x + normal.y * dir.y > 0)
+      normal = {-normal.x, -normal.y};
+  }
+
+  if (!found)
+    return false;
+
+  hit->distance = best;
+  hit->point = {origin.x + dir.x * best, origin.y + dir.y * best};
+  hit->normal = normal;
+  return true;
+}
+
+inline bool ColliderZone::collide(Collider *other) {
+  return other->isCollidingWithZone(this);
+}
+
 inline bool ColliderZone::isCollidingWithZone(ColliderZone *z) {
+  if (!canCollideWith(z))
+    return false;
+
   auto mePoints = getZoneBorder();
   auto zPoints = z->getZoneBorder();
 
-  bool ret = containsOneOfPoints(mePoints, *zPoints);
+  bool ret = containsOneOfPoints(mePoints->data(), mePoints->size(),
+                                 zPoints->data(), zPoints->size());
 
   if (!ret)
-    return containsOneOfPoints(zPoints, *mePoints);
+    return containsOneOfPoints(zPoints->data(), zPoints->size(),
+                               mePoints->data(), mePoints->size());
 
   return ret;
 }
@@ -340,22 +687,64 @@ inline bool ColliderPoint::containsPoint(float x, float y) {
 };
 
 inline bool ColliderPoint::isCollidingWithPoint(ColliderPoint *p) {
+  if (!canCollideWith(p))
+    return false;
+
   auto p2 = p->getPosition();
   return containsPoint(p2.x, p2.y);
 }
 
 inline bool ColliderPoint::isCollidingWithRect(ColliderRect *r) {
+  if (!canCollideWith(r))
+    return false;
+
   return r->rectContainsPoint(r->getRect(), this->getPosition());
 }
 
 inline bool ColliderPoint::isCollidingWithCircle(ColliderCircle *c) {
+  if (!canCollideWith(c))
+    return false;
+
   return c->containsPoint(getPosition());
 }
 
 inline bool ColliderPoint::isCollidingWithZone(ColliderZone *z) {
+  if (!canCollideWith(z))
+    return false;
+
   return zoneContainsPoint(z->getZoneBorder(), this->getPosition());
 }
 
+// The point is a single pixel, so the box is one pixel wide
+inline Rectangle ColliderPoint::getBounds() {
+  auto p = getPosition();
+  return {p.x - 0.5f, p.y - 0.5f, 1, 1};
+}
+
+inline bool ColliderPoint::castRay(Vector2 origin, Vector2 dir, float maxDist,
+                                   RayHit *hit) {
+  auto p = getPosition();
+
+  float t = (p.x - origin.x) * dir.x + (p.y - origin.y) * dir.y;
+  if (t < 0 || t > maxDist)
+    return false;
+
+  // The ray must pass within half a pixel
+  float dx = origin.x + dir.x * t - p.x;
+  float dy = origin.y + dir.y * t - p.y;
+  if (dx * dx + dy * dy > 0.25f)
+    return false;
+
+  hit->distance = t;
+  hit->point = p;
+  hit->normal = {-dir.x, -dir.y};
+  return true;
+}
+
+inline bool ColliderPoint::collide(Collider *other) {
+  return other->isCollidingWithPoint(this);
+}
+
 //==============================================================================
 // BM: Collider - Rect - Implementation
 //==============================================================================
@@ -369,33 +758,502 @@ inline bool ColliderRect::containsPoint(float x, float y) {
   return x >= r.x && x <= r.x + r.width && y >= r.y && y <= r.y + r.height;
 };
 
+// Overlap on both axes (also catches rects, that cross without any corner
+// inside the other)
 inline bool ColliderRect::rectInRect(Rectangle r1, Rectangle r2) {
-
-  bool tlIn = rectContainsPoint(r1, {r2.x, r2.y});
-  bool trIn = rectContainsPoint(r1, {r2.x + r2.width, r2.y});
-  bool blIn = rectContainsPoint(r1, {r2.x, r2.y + r2.height});
-  bool brIn = rectContainsPoint(r1, {r2.x + r2.width, r2.y + r2.height});
-
-  return (tlIn || trIn || blIn || brIn);
+  return r1.x <= r2.x + r2.width && r2.x <= r1.x + r1.width &&
+         r1.y <= r2.y + r2.height && r2.y <= r1.y + r1.height;
 }
 
 inline bool ColliderRect::isCollidingWithPoint(ColliderPoint *p) {
+  if (!canCollideWith(p))
+    return false;
+
   return this->rectContainsPoint(this->getRect(), p->getPosition());
 }
 
 inline bool ColliderRect::isCollidingWithCircle(ColliderCircle *c) {
+  if (!canCollideWith(c))
+    return false;
+
   return c->isCollidingWithRect(this);
 }
 
 inline bool ColliderRect::isCollidingWithRect(ColliderRect *r) {
+  if (!canCollideWith(r))
+    return false;
+
   auto r1 = this->getRect();
   auto r2 = r->getRect();
-  return rectInRect(r1, r2) || rectInRect(r2, r2);
+  return rectInRect(r1, r2);
 }
 
 inline bool ColliderRect::isCollidingWithZone(ColliderZone *z) {
+  if (!canCollideWith(z))
+    return false;
+
   return z->isCollidingWithRect(this);
 }
 
+inline Rectangle ColliderRect::getBounds() { return getRect(); }
+
+// Slab test: the ray enters the rect, once it is inside both, the x and the y
+// range of the rect
+inline bool ColliderRect::castRay(Vector2 origin, Vector2 dir, float maxDist,
+                                  RayHit *hit) {
+  auto r = getRect();
+
+  if (rectContainsPoint(r, origin)) {
+    hit->distance = 0;
+    hit->point = origin;
+    hit->normal = {-dir.x, -dir.y};
+    return true;
+  }
+
+  float tNear = -INFINITY;
+  float tFar = INFINITY;
+  Vector2 normal = {0, 0};
+
+  float o[2] = {origin.x, origin.y};
+  float d[2] = {dir.x, dir.y};
+  float lo[2] = {r.x, r.y};
+  float hi[2] = {r.x + r.width, r.y + r.height};
+
+  for (int axis = 0; axis < 2; axis++) {
+    if (d[axis] == 0) {
+      if (o[axis] < lo[axis] || o[axis] > hi[axis])
+        return false;
+      continue;
+    }
+
+    float t1 = (lo[axis] - o[axis]) / d[axis];
+    float t2 = (hi[axis] - o[axis]) / d[axis];
+    float side = -1;
+    if (t1 > t2) {
+      std::swap(t1, t2);
+      side = 1;
+    }
+
+    if (t1 > tNear) {
+      tNear = t1;
+      normal = axis == 0 ? Vector2{side, 0} : Vector2{0, side};
+    }
+    tFar = std::min(tFar, t2);
+  }
+
+  if (tNear > tFar || tNear < 0 || tNear > maxDist)
+    return false;
+
+  hit->distance = tNear;
+  hit->point = {origin.x + dir.x * tNear, origin.y + dir.y * tNear};
+  hit->normal = normal;
+  return true;
+}
+
+inline bool ColliderRect::collide(Collider *other) {
+  return other->isCollidingWithRect(this);
+}
+
+// BM: ColliderGrid - Implementation
+//==============================================================================
+inline ColliderGrid::ColliderGrid(float cellSize)
+    : _cellSize(cellSize > 0 ? cellSize : COLLIDER_GRID_CELL), _entries(),
+      _free(), _index(), _cells(), _stamp(0), _minX(0), _minY(0), _maxX(-1),
+      _maxY(-1) {}
+
+inline void ColliderGrid::Add(Collider *c) {
+  if (c == nullptr || _index.count(c) != 0)
+    return;
+
+  unsigned int e;
+  if (!_free.empty()) {
+    e = _free.back();
+    _free.pop_back();
+  } else {
+    e = _entries.size();
+    _entries.push_back({});
+  }
+
+  _entries[e] = {c, 0, 0, {0, 0, 0, 0}, 0, 0, -1, -1, 0};
+  _index[c] = e;
+  insert(e);
+}
+
+inline void ColliderGrid::Remove(Collider *c) {
+  auto found = _index.find(c);
+  if (found == _index.end())
+    return;
+
+  unsigned int e = found->second;
+  erase(e);
+  _entries[e].collider = nullptr;
+  _free.push_back(e);
+  _index.erase(found);
+}
+
+inline void ColliderGrid::Moved(Collider *c) {
+  auto found = _index.find(c);
+  if (found == _index.end())
+    return;
+
+  erase(found->second);
+  insert(found->second);
+}
+
+inline void ColliderGrid::Refresh() {
+  _cells.clear();
+  _minX = _minY = 0;
+  _maxX = _maxY = -1;
+
+  for (unsigned int e = 0; e < _entries.size(); e++) {
+    if (_entries[e].collider != nullptr)
+      insert(e);
+  }
+}
+
+inline void ColliderGrid::Clear() {
+  _entries.clear();
+  _free.clear();
+  _index.clear();
+  _cells.clear();
+  _minX = _minY = 0;
+  _maxX = _maxY = -1;
+}
+
+inline unsigned int ColliderGrid::Count() { return _index.size(); }
+
+inline long long ColliderGrid::cellKey(int x, int y) {
+  return (long long)(((unsigned long long)(unsigned int)x << 32) |
+                     (unsigned int)y);
+}
+
+inline bool ColliderGrid::boundsTouch(Rectangle a, Rectangle b) {
+  return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+         a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+inline unsigned int ColliderGrid::nextStamp() {
+  if (++_stamp == 0) {
+    for (Entry &entry : _entries)
+      entry.stamp = 0;
+    _stamp = 1;
+  }
+  return _stamp;
+}
+
+inline int ColliderGrid::cellOf(float v) {
+  float c = std::floor(v / _cellSize);
+
+  // Keeps huge (or NaN) coordinates from overflowing the cell index
+  if (!(c > -1e9f))
+    return -1000000000;
+  if (c > 1e9f)
+    return 1000000000;
+  return (int)c;
+}
+
+inline void ColliderGrid::insert(unsigned int e) {
+  Entry &entry = _entries[e];
+  Rectangle b = entry.collider->getBounds();
+  entry.layer = entry.collider->_layer;
+  entry.mask = entry.collider->_mask;
+  entry.bounds = b;
+
+  entry.x0 = cellOf(b.x);
+  entry.y0 = cellOf(b.y);
+  entry.x1 = cellOf(b.x + b.width);
+  entry.y1 = cellOf(b.y + b.height);
+
+  for (int y = entry.y0; y <= entry.y1; y++)
+    for (int x = entry.x0; x <= entry.x1; x++)
+      _cells[cellKey(x, y)].push_back(e);
+
+  if (_maxX < _minX) {
+    _minX = entry.x0;
+    _minY = entry.y0;
+    _maxX = entry.x1;
+    _maxY = entry.y1;
+  } else {
+    _minX = std::min(_minX, entry.x0);
+    _minY = std::min(_minY, entry.y0);
+    _maxX = std::max(_maxX, entry.x1);
+    _maxY = std::max(_maxY, entry.y1);
+  }
+}
+
+inline void ColliderGrid::erase(unsigned int e) {
+  Entry &entry = _entries[e];
+
+  for (int y = entry.y0; y <= entry.y1; y++) {
+    for (int x = entry.x0; x <= entry.x1; x++) {
+      auto cell = _cells.find(cellKey(x, y));
+      if (cell == _cells.end())
+        continue;
+
+      std::vector<unsigned int> &list = cell->second;
+      auto at = std::find(list.begin(), list.end(), e);
+      if (at != list.end()) {
+        *at = list.back();
+        list.pop_back();
+      }
+      if (list.empty())
+        _cells.erase(cell);
+    }
+  }
+
+  entry.x1 = entry.x0 - 1;
+  entry.y1 = entry.y0 - 1;
+}
+
+// Amanatides & Woo: steps from cell to cell, always into the neighbor, whose
+// border the ray crosses first
+template <typename Fn>
+inline void ColliderGrid::traverse(Vector2 origin, Vector2 dir, float maxDist,
+                                   unsigned int mask, Fn hitFn) {
+  if (_index.empty())
+    return;
+
+  // Each Collider is tested once per query, even if it spans many cells
+  unsigned int stamp = nextStamp();
+
+  // Clip the ray to the cells, that hold Colliders
+  float o[2] = {origin.x, origin.y};
+  float d[2] = {dir.x, dir.y};
+  float lo[2] = {_minX * _cellSize, _minY * _cellSize};
+  float hi[2] = {(_maxX + 1) * _cellSize, (_maxY + 1) * _cellSize};
+  float tEnter = 0;
+  float tExit = maxDist;
+
+  for (int axis = 0; axis < 2; axis++) {
+    if (d[axis] == 0) {
+      if (o[axis] < lo[axis] || o[axis] > hi[axis])
+        return;
+      continue;
+    }
+
+    float t1 = (lo[axis] - o[axis]) / d[axis];
+    float t2 = (hi[axis] - o[axis]) / d[axis];
+    if (t1 > t2)
+      std::swap(t1, t2);
+    tEnter = std::max(tEnter, t1);
+    tExit = std::min(tExit, t2);
+  }
+
+  if (tEnter > tExit)
+    return;
+
+  int x = cellOf(origin.x + dir.x * tEnter);
+  int y = cellOf(origin.y + dir.y * tEnter);
+  x = std::max(_minX, std::min(_maxX, x));
+  y = std::max(_minY, std::min(_maxY, y));
+
+  int stepX = dir.x > 0 ? 1 : -1;
+  int stepY = dir.y > 0 ? 1 : -1;
+  float deltaX = dir.x != 0 ? _cellSize / std::fabs(dir.x) : INFINITY;
+  float deltaY = dir.y != 0 ? _cellSize / std::fabs(dir.y) : INFINITY;
+  float nextX = dir.x != 0
+                    ? ((x + (stepX > 0 ? 1 : 0)) * _cellSize - origin.x) / dir.x
+                    : INFINITY;
+  float nextY = dir.y != 0
+                    ? ((y + (stepY > 0 ? 1 : 0)) * _cellSize - origin.y) / dir.y
+                    : INFINITY;
+
+  float bound = maxDist;
+  while (true) {
+    auto cell = _cells.find(cellKey(x, y));
+    if (cell != _cells.end()) {
+      for (unsigned int e : cell->second) {
+        Entry &entry = _entries[e];
+        if (entry.stamp == stamp || (entry.layer & mask) == 0)
+          continue;
+        entry.stamp = stamp;
+        bound = hitFn(entry.collider, bound);
+      }
+    }
+
+    // A hit before the end of this cell can't be undercut by later cells
+    float cellExit = std::min(nextX, nextY);
+    if (bound <= cellExit || cellExit > tExit)
+      return;
+
+    if (nextX < nextY) {
+      x += stepX;
+      nextX += deltaX;
+    } else {
+      y += stepY;
+      nextY += deltaY;
+    }
+
+    if (x < _minX || x > _maxX || y < _minY || y > _maxY)
+      return;
+  }
+}
+
+inline bool ColliderGrid::castClosest(Vector2 origin, Vector2 dir,
+                                      float maxDist, unsigned int mask,
+                                      RayHit *hit) {
+  RayHit best;
+  traverse(origin, dir, maxDist, mask, [&](Collider *c, float bound) {
+    RayHit h;
+    if (!c->castRay(origin, dir, bound, &h))
+      return bound;
+    if (best.collider != nullptr && h.distance >= best.distance)
+      return bound;
+
+    best = h;
+    best.collider = c;
+    return h.distance;
+  });
+
+  if (best.collider == nullptr)
+    return false;
+
+  *hit = best;
+  return true;
+}
+
+inline std::vector<RayHit> ColliderGrid::castAll(Vector2 origin, Vector2 dir,
+                                                 float maxDist,
+                                                 unsigned int mask) {
+  std::vector<RayHit> hits;
+  traverse(origin, dir, maxDist, mask, [&](Collider *c, float bound) {
+    RayHit h;
+    if (c->castRay(origin, dir, bound, &h)) {
+      h.collider = c;
+      hits.push_back(h);
+    }
+    return bound;
+  });
+
+  std::sort(hits.begin(), hits.end(), [](const RayHit &a, const RayHit &b) {
+    return a.distance < b.distance;
+  });
+  return hits;
+}
+
+inline bool ColliderGrid::Raycast(Vector2 origin, Vector2 direction,
+                                  float maxDistance, RayHit *hit,
+                                  unsigned int mask) {
+  float len = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+  if (len == 0 || !(maxDistance >= 0))
+    return false;
+
+  Vector2 dir = {direction.x / len, direction.y / len};
+  return castClosest(origin, dir, maxDistance, mask, hit);
+}
+
+inline bool ColliderGrid::SegmentCast(Vector2 from, Vector2 to, RayHit *hit,
+                                      unsigned int mask) {
+  float dx = to.x - from.x;
+  float dy = to.y - from.y;
+  float len = std::sqrt(dx * dx + dy * dy);
+
+  // A segment of length 0 only hits, what contains from
+  if (len == 0)
+    return castClosest(from, {1, 0}, 0, mask, hit);
+
+  return castClosest(from, {dx / len, dy / len}, len, mask, hit);
+}
+
+inline std::vector<RayHit> ColliderGrid::RaycastAll(Vector2 origin,
+                                                    Vector2 direction,
+                                                    float maxDistance,
+                                                    unsigned int mask) {
+  float len = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+  if (len == 0 || !(maxDistance >= 0))
+    return {};
+
+  return castAll(origin, {direction.x / len, direction.y / len}, maxDistance,
+                 mask);
+}
+
+inline std::vector<RayHit> ColliderGrid::SegmentCastAll(Vector2 from,
+                                                        Vector2 to,
+                                                        unsigned int mask) {
+  float dx = to.x - from.x;
+  float dy = to.y - from.y;
+  float len = std::sqrt(dx * dx + dy * dy);
+
+  if (len == 0)
+    return castAll(from, {1, 0}, 0, mask);
+
+  return castAll(from, {dx / len, dy / len}, len, mask);
+}
+
+inline void ColliderGrid::Raycast(const std::vector<Ray2D> &rays,
+                                  std::vector<RayHit> &hits,
+                                  unsigned int mask) {
+  hits.resize(rays.size());
+
+  for (size_t a = 0; a < rays.size(); a++) {
+    const Ray2D &r = rays[a];
+    if (!Raycast(r.origin, r.direction, r.maxDistance, &hits[a], mask))
+      hits[a] = RayHit();
+  }
+}
+
+template <typename Fn> inline void ColliderGrid::ForEachCollidingPair(Fn fn) {
+  for (auto &cell : _cells) {
+    unsigned long long key = cell.first;
+    int x = (int)(unsigned int)(key >> 32);
+    int y = (int)(unsigned int)key;
+    const std::vector<unsigned int> &list = cell.second;
+
+    for (size_t i = 0; i < list.size(); i++) {
+      const Entry &a = _entries[list[i]];
+
+      for (size_t j = i + 1; j < list.size(); j++) {
+        const Entry &b = _entries[list[j]];
+        if ((a.layer & b.mask) == 0 || (b.layer & a.mask) == 0)
+          continue;
+
+        // Pairs, that share several cells, are tested in the first one only
+        if (std::max(a.x0, b.x0) != x || std::max(a.y0, b.y0) != y)
+          continue;
+
+        if (boundsTouch(a.bounds, b.bounds) && b.collider->collide(a.collider))
+          fn(a.collider, b.collider);
+      }
+    }
+  }
+}
+
+template <typename Fn>
+inline void ColliderGrid::ForEachCollidingWith(Collider *c, Fn fn) {
+  if (_index.empty())
+    return;
+
+  unsigned int layer = c->_layer;
+  unsigned int mask = c->_mask;
+  Rectangle b = c->getBounds();
+  unsigned int stamp = nextStamp();
+
+  int x0 = std::max(_minX, cellOf(b.x));
+  int y0 = std::max(_minY, cellOf(b.y));
+  int x1 = std::min(_maxX, cellOf(b.x + b.width));
+  int y1 = std::min(_maxY, cellOf(b.y + b.height));
+
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) {
+      auto cell = _cells.find(cellKey(x, y));
+      if (cell == _cells.end())
+        continue;
+
+      for (unsigned int e : cell->second) {
+        Entry &other = _entries[e];
+        if (other.stamp == stamp || other.collider == c)
+          continue;
+        other.stamp = stamp;
+
+        if ((layer & other.mask) == 0 || (other.layer & mask) == 0)
+          continue;
+
+        if (boundsTouch(b, other.bounds) && c->collide(other.collider))
+          fn(other.collider);
+      }
+    }
+  }
+}
+
 }; // namespace Theater
 #endif
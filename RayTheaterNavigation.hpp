@@ -0,0 +1,1337 @@
+#ifndef RayTheaterNavigation_H
+#define RayTheaterNavigation_H 1
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <raylib.h>
+#include <unordered_map>
+#include <vector>
+
+#include "RayTheater.hpp"
+#include "RayTheaterCollider.hpp"
+
+namespace Theater {
+
+// Max number of paths, the Navigator remembers
+#ifndef NAV_PATH_CACHE
+#define NAV_PATH_CACHE 256
+#endif
+
+// Max number of path requests, one job on the WorkerPool works through
+#ifndef NAV_REQUESTS_PER_JOB
+#define NAV_REQUESTS_PER_JOB 8
+#endif
+
+// Max number of flow fields (goals), the Navigator keeps up to date
+#ifndef NAV_FLOW_FIELDS
+#define NAV_FLOW_FIELDS 8
+#endif
+
+// Width and height (in cells) of the tiles, flow fields are computed in
+#ifndef NAV_FLOW_TILE
+#define NAV_FLOW_TILE 16
+#endif
+
+enum PathMode {
+  /** @brief plain A*, visits every cell on the way */
+  PATH_ASTAR,
+  /** @brief Jump Point Search, skips over open areas (same paths as A*) */
+  PATH_JPS
+};
+
+/** @brief Identifies a path request (0 = none) */
+typedef unsigned int PathRequest;
+
+// BM: NavGrid - Class
+//==============================================================================
+/** @brief The cells of the navigation area, and which of them are blocked.
+ * Never changed once published, so searches on other threads can read it
+ * while the Navigator builds the next one.
+ */
+struct NavGrid {
+  Vector2 origin;
+  float cellSize;
+  int cols;
+  int rows;
+  unsigned int version;
+  std::vector<unsigned char> blocked;
+
+  bool walkable(int x, int y) const {
+    return x >= 0 && y >= 0 && x < cols && y < rows &&
+           blocked[y * cols + x] == 0;
+  }
+
+  int cellAt(Vector2 loc) const {
+    int x = (int)std::floor((loc.x - origin.x) / cellSize);
+    int y = (int)std::floor((loc.y - origin.y) / cellSize);
+    if (x < 0 || y < 0 || x >= cols || y >= rows)
+      return -1;
+    return y * cols + x;
+  }
+
+  Vector2 center(int cell) const {
+    return {origin.x + (cell % cols + 0.5f) * cellSize,
+            origin.y + (cell / cols + 0.5f) * cellSize};
+  }
+};
+
+// BM: FlowField - Class
+//==============================================================================
+class Navigator;
+
+/** @brief The direction towards one goal, for every cell of the Navigators
+ * grid. Many Actors heading for the same goal share one field, and look up
+ * their direction each tick, instead of searching a path each.
+ *
+ * The Navigator keeps the field up to date, when obstacles change.
+ */
+class FlowField {
+public:
+  /** @return direction (length 1) to move into from loc, towards the goal
+   * ({0, 0} = at the goal, unreachable or outside of the grid) */
+  Vector2 Direction(Vector2 loc) const;
+
+  /** @return length (in pixels) of the way from loc to the goal
+   * (INFINITY = unreachable) */
+  float Distance(Vector2 loc) const;
+
+  bool Reachable(Vector2 loc) const;
+
+  /** @return center of the goals cell */
+  Vector2 Goal() const;
+
+  /** @return number of times, the field was updated after obstacles changed */
+  unsigned int Version() const;
+
+private:
+  friend Navigator;
+
+  std::shared_ptr<const NavGrid> _grid;
+  int _goal;
+  unsigned int _version;
+  int _tilesX;
+  int _tilesY;
+
+  std::vector<float> _cost;         // in cells, INFINITY = unreachable
+  std::vector<unsigned char> _step; // into NavSteps (8 = none)
+  std::list<int>::iterator _lru;
+
+  int cellAt(Vector2 loc) const;
+};
+
+// The 8 moves on the grid, and their length (the 9th is standing still)
+static const int NavStepX[9] = {1, 1, 0, -1, -1, -1, 0, 1, 0};
+static const int NavStepY[9] = {0, 1, 1, 1, 0, -1, -1, -1, 0};
+static const float NavStepLength[9] = {1,          1.41421356f, 1,
+                                       1.41421356f, 1,          1.41421356f,
+                                       1,          1.41421356f, 0};
+static const Vector2 NavStepDirection[9] = {
+    {1, 0},           {0.70710678f, 0.70710678f},
+    {0, 1},           {-0.70710678f, 0.70710678f},
+    {-1, 0},          {-0.70710678f, -0.70710678f},
+    {0, -1},          {0.70710678f, -0.70710678f},
+    {0, 0}};
+
+// BM: Navigator - Class
+//==============================================================================
+/** @brief Finds paths around obstacles on a grid. Searches run on the Stages
+ * WorkerPool; their results are handed out on the main thread, once the
+ * Navigator ticks. Recent paths are cached.
+ *
+ * Obstacles are ColliderRects and ColliderZones. They are expected to stay
+ * where they are; tell the Navigator, once one moved (ObstacleChanged). Only
+ * the cells around it are rebuilt, and only cached paths through that area
+ * are dropped.
+ */
+class Navigator : public Actor, public Ticking {
+public:
+  typedef std::function<void(PathRequest, const std::vector<Vector2> &path)>
+      t_PathHandler;
+
+  /** @param area - the area paths may lead through (in Stage coordinates)
+   * @param cellSize - size of a grid cell in pixels */
+  Navigator(Rectangle area, float cellSize);
+  Navigator(const Navigator &) = delete;
+  Navigator &operator=(const Navigator &) = delete;
+
+  /** @brief blocks all cells, whose center is inside the obstacle */
+  void AddObstacle(ColliderRect *obstacle);
+  void AddObstacle(ColliderZone *obstacle);
+  void RemoveObstacle(Collider *obstacle);
+
+  /** @brief to be called, once an obstacle moved or changed its shape */
+  void ObstacleChanged(Collider *obstacle);
+
+  /** @brief searches a path in the background. The handler is called on the
+   * main thread with the waypoints from `from` to `to` (empty = no path).
+   * @return id of the request */
+  PathRequest FindPath(Vector2 from, Vector2 to, t_PathHandler done,
+                       PathMode mode = PATH_JPS);
+
+  /** @brief searches a path right away, on the calling thread */
+  std::vector<Vector2> FindPathNow(Vector2 from, Vector2 to,
+                                   PathMode mode = PATH_JPS);
+
+  /** @brief drops the request; its handler is not called */
+  void Cancel(PathRequest r);
+
+  bool IsBlocked(Vector2 loc);
+
+  /** @return number of requests, that wait for their path */
+  unsigned int Pending();
+
+  /** @return number of cached paths */
+  unsigned int CacheSize();
+
+  /** @return the current grid */
+  std::shared_ptr<const NavGrid> GetGrid();
+
+  /** @return the flow field towards the goal. Computed right away (on the
+   * Stages WorkerPool), unless the field of the goals cell is known. */
+  std::shared_ptr<const FlowField> GetFlowField(Vector2 goal);
+
+  /** @return number of flow fields, that are kept up to date */
+  unsigned int FlowFieldCount();
+
+private:
+  struct Obstacle {
+    Collider *collider;
+    ColliderRect *rect;
+    ColliderZone *zone;
+    Rectangle bounds; // where it blocked cells the last time
+  };
+
+  // A range of cells (inclusive)
+  struct CellArea {
+    int x0, y0, x1, y1;
+  };
+
+  struct Request {
+    PathRequest id;
+    Vector2 from;
+    Vector2 to;
+    PathMode mode;
+    uint64_t key;
+    t_PathHandler done;
+  };
+
+  // A search on the WorkerPool
+  struct Search {
+    uint64_t key;
+    int from;
+    int to;
+    PathMode mode;
+  };
+
+  struct Result {
+    uint64_t key;
+    unsigned int version;
+    bool found;
+    std::vector<int> cells; // waypoints
+  };
+
+  // Results handed back by the WorkerPool
+  struct Inbox {
+    std::mutex mutex;
+    std::vector<Result> results;
+  };
+
+  struct CachedPath {
+    std::vector<int> cells;
+    bool found;
+    CellArea area;
+    std::list<uint64_t>::iterator lru;
+  };
+
+  std::shared_ptr<const NavGrid> _grid;
+  std::vector<Obstacle> _obstacles;
+  std::vector<CellArea> _dirty;
+
+  PathRequest _nextRequest;
+  std::vector<Request> _queued;
+  std::unordered_map<PathRequest, Request> _inFlight;
+  std::unordered_map<uint64_t, std::vector<PathRequest>> _waiting;
+  std::shared_ptr<Inbox> _inbox;
+
+  std::unordered_map<uint64_t, CachedPath> _cache;
+  std::list<uint64_t> _lru; // most recent first
+
+  std::unordered_map<int, std::shared_ptr<FlowField>> _fields;
+  std::list<int> _fieldLru; // most recent first
+
+  // The Stages WorkerPool, while on the Stage
+  WorkerPool *_workers;
+
+  // Helpers
+  //----------------------------------------------------------------------------
+  static Rectangle boundsOf(const Obstacle &o);
+  CellArea cellsOf(Rectangle r);
+  void markDirty(Rectangle r);
+  void rebuild();
+  void rasterize(NavGrid &grid, const Obstacle &o, CellArea area);
+
+  uint64_t keyOf(int from, int to, PathMode mode);
+  std::vector<Vector2> toWorld(const NavGrid &grid,
+                               const std::vector<int> &cells, Vector2 from,
+                               Vector2 to);
+  void remember(uint64_t key, const Result &r);
+  bool crossesBlocked(const NavGrid &grid, const std::vector<int> &cells);
+  void submit(Play p);
+  void deliver();
+
+  static void search(const NavGrid &grid, int from, int to, PathMode mode,
+                     Result &out);
+  static int jump(const NavGrid &grid, int x, int y, int dx, int dy, int goal);
+  static int jumpStraight(const NavGrid &grid, int x, int y, int dx, int dy,
+                          int goal);
+
+  void repairFlow(FlowField &f, const NavGrid &old);
+  void solveFlow(FlowField &f, std::vector<int> tiles);
+  void flowDirections(FlowField &f, const std::vector<int> &tiles);
+  static bool solveTile(const FlowField &f, int tile, float *out);
+  static bool canStep(const NavGrid &grid, int x, int y, int step);
+
+  // Interfaces
+  //----------------------------------------------------------------------------
+public:
+  // Implement - Ticking
+  //----------------------------------------------------------------------------
+  void OnTick(Play) override;
+
+private:
+  // Implement - Actor
+  //----------------------------------------------------------------------------
+  void OnStageEnter(Play) override;
+  void OnStageLeave(Play) override;
+};
+
+// BM: Navigator - Implementation
+//==============================================================================
+inline Navigator::Navigator(Rectangle area, float cellSize)
+    : Actor(), Ticking(this), _grid(), _obstacles(), _dirty(),
+      _nextRequest(0), _queued(), _inFlight(), _waiting(),
+      _inbox(new Inbox()), _cache(), _lru(), _fields(), _fieldLru(),
+      _workers(NULL) {
+  NavGrid *g = new NavGrid();
+  g->origin = {area.x, area.y};
+  g->cellSize = cellSize;
+  g->cols = std::max(1, (int)std::ceil(area.width / cellSize));
+  g->rows = std::max(1, (int)std::ceil(area.height / cellSize));
+  g->version = 0;
+  g->blocked.assign(g->cols * g->rows, 0);
+  _grid.reset(g);
+}
+
+inline void Navigator::AddObstacle(ColliderRect *obstacle) {
+  Obstacle o = {obstacle, obstacle, NULL, {0, 0, 0, 0}};
+  o.bounds = boundsOf(o);
+  _obstacles.push_back(o);
+  markDirty(o.bounds);
+}
+
+inline void Navigator::AddObstacle(ColliderZone *obstacle) {
+  Obstacle o = {obstacle, NULL, obstacle, {0, 0, 0, 0}};
+  o.bounds = boundsOf(o);
+  _obstacles.push_back(o);
+  markDirty(o.bounds);
+}
+
+inline void Navigator::RemoveObstacle(Collider *obstacle) {
+  for (size_t a = 0; a < _obstacles.size(); a++)
+    if (_obstacles[a].collider == obstacle) {
+      markDirty(_obstacles[a].bounds);
+      _obstacles[a] = _obstacles.back();
+      _obstacles.pop_back();
+      return;
+    }
+}
+
+inline void Navigator::ObstacleChanged(Collider *obstacle) {
+  for (Obstacle &o : _obstacles)
+    if (o.collider == obstacle) {
+      // Free the cells, it blocked before, and block the new ones
+      markDirty(o.bounds);
+      o.bounds = boundsOf(o);
+      markDirty(o.bounds);
+      return;
+    }
+}
+
+inline PathRequest Navigator::FindPath(Vector2 from, Vector2 to,
+                                       t_PathHandler done, PathMode mode) {
+  // 0 is never handed out
+  if (++_nextRequest == 0)
+    ++_nextRequest;
+
+  Request r = {_nextRequest, from, to, mode, 0, done};
+  _queued.push_back(r);
+  return r.id;
+}
+
+inline std::vector<Vector2> Navigator::FindPathNow(Vector2 from, Vector2 to,
+                                                   PathMode mode) {
+  if (!_dirty.empty())
+    rebuild();
+
+  const NavGrid &grid = *_grid;
+  Result r = {0, grid.version, false, {}};
+  search(grid, grid.cellAt(from), grid.cellAt(to), mode, r);
+
+  if (!r.found)
+    return std::vector<Vector2>();
+  return toWorld(grid, r.cells, from, to);
+}
+
+inline void Navigator::Cancel(PathRequest r) {
+  _inFlight.erase(r);
+  for (size_t a = 0; a < _queued.size(); a++)
+    if (_queued[a].id == r) {
+      _queued.erase(_queued.begin() + a);
+      return;
+    }
+}
+
+inline bool Navigator::IsBlocked(Vector2 loc) {
+  if (!_dirty.empty())
+    rebuild();
+
+  int cell = _grid->cellAt(loc);
+  return cell < 0 || _grid->blocked[cell] != 0;
+}
+
+inline unsigned int Navigator::Pending() {
+  return _queued.size() + _inFlight.size();
+}
+
+inline unsigned int Navigator::CacheSize() { return _cache.size(); }
+
+inline std::shared_ptr<const NavGrid> Navigator::GetGrid() {
+  if (!_dirty.empty())
+    rebuild();
+  return _grid;
+}
+
+inline Rectangle Navigator::boundsOf(const Obstacle &o) {
+  if (o.rect != NULL)
+    return o.rect->getRect();
+
+  std::vector<Vector2> *border = o.zone->getZoneBorder();
+  if (border->empty())
+    return {0, 0, 0, 0};
+
+  float minX = border->at(0).x, maxX = minX;
+  float minY = border->at(0).y, maxY = minY;
+  for (const Vector2 &v : *border) {
+    minX = std::min(minX, v.x);
+    maxX = std::max(maxX, v.x);
+    minY = std::min(minY, v.y);
+    maxY = std::max(maxY, v.y);
+  }
+  return {minX, minY, maxX - minX, maxY - minY};
+}
+
+inline Navigator::CellArea Navigator::cellsOf(Rectangle r) {
+  const NavGrid &g = *_grid;
+  CellArea a;
+  a.x0 = std::max(0, (int)std::floor((r.x - g.origin.x) / g.cellSize));
+  a.y0 = std::max(0, (int)std::floor((r.y - g.origin.y) / g.cellSize));
+  a.x1 = std::min(g.cols - 1,
+                  (int)std::floor((r.x + r.width - g.origin.x) / g.cellSize));
+  a.y1 = std::min(g.rows - 1,
+                  (int)std::floor((r.y + r.height - g.origin.y) / g.cellSize));
+  return a;
+}
+
+inline void Navigator::markDirty(Rectangle r) {
+  CellArea a = cellsOf(r);
+  if (a.x0 <= a.x1 && a.y0 <= a.y1)
+    _dirty.push_back(a);
+}
+
+// Builds the next grid from the current one; only the dirty cells are
+// cleared and filled again
+inline void Navigator::rebuild() {
+  NavGrid *next = new NavGrid(*_grid);
+  next->version++;
+
+  for (const CellArea &d : _dirty) {
+    for (int y = d.y0; y <= d.y1; y++)
+      std::fill(next->blocked.begin() + y * next->cols + d.x0,
+                next->blocked.begin() + y * next->cols + d.x1 + 1, 0);
+
+    for (const Obstacle &o : _obstacles) {
+      CellArea oa = cellsOf(o.bounds);
+      CellArea both = {std::max(oa.x0, d.x0), std::max(oa.y0, d.y0),
+                       std::min(oa.x1, d.x1), std::min(oa.y1, d.y1)};
+      if (both.x0 <= both.x1 && both.y0 <= both.y1)
+        rasterize(*next, o, both);
+    }
+  }
+
+  // Compare with the current grid, which cells got freed or blocked
+  bool freed = false;
+  std::vector<CellArea> blocked;
+  for (const CellArea &d : _dirty) {
+    bool blocks = false;
+    for (int y = d.y0; y <= d.y1; y++)
+      for (int x = d.x0; x <= d.x1; x++) {
+        int cell = y * next->cols + x;
+        freed |= _grid->blocked[cell] != 0 && next->blocked[cell] == 0;
+        blocks |= _grid->blocked[cell] == 0 && next->blocked[cell] != 0;
+      }
+    if (blocks)
+      blocked.push_back(d);
+  }
+
+  // A freed cell may open a shorter path anywhere, even between cells, that
+  // could not reach each other before: all cached paths are dropped. A newly
+  // blocked cell only breaks the paths, whose area it lies in.
+  if (freed) {
+    _cache.clear();
+    _lru.clear();
+  } else {
+    auto c = _cache.begin();
+    while (c != _cache.end()) {
+      bool touched = false;
+      for (const CellArea &d : blocked)
+        touched |= c->second.area.x0 <= d.x1 && d.x0 <= c->second.area.x1 &&
+                   c->second.area.y0 <= d.y1 && d.y0 <= c->second.area.y1;
+
+      if (touched) {
+        _lru.erase(c->second.lru);
+        c = _cache.erase(c);
+      } else {
+        ++c;
+      }
+    }
+  }
+
+  std::shared_ptr<const NavGrid> old = _grid;
+  _grid.reset(next);
+
+  for (auto &field : _fields)
+    repairFlow(*field.second, *old);
+  _dirty.clear();
+}
+
+inline void Navigator::rasterize(NavGrid &grid, const Obstacle &o,
+                                 CellArea area) {
+  for (int y = area.y0; y <= area.y1; y++)
+    for (int x = area.x0; x <= area.x1; x++) {
+      Vector2 c = grid.center(y * grid.cols + x);
+      bool inside;
+      if (o.rect != NULL) {
+        Rectangle r = o.bounds;
+        inside = c.x >= r.x && c.y >= r.y && c.x <= r.x + r.width &&
+                 c.y <= r.y + r.height;
+      } else {
+        inside = Collider::zoneContainsPoint(o.zone->getZoneBorder(), c);
+      }
+
+      if (inside)
+        grid.blocked[y * grid.cols + x] = 1;
+    }
+}
+
+inline uint64_t Navigator::keyOf(int from, int to, PathMode mode) {
+  return ((uint64_t)(unsigned int)from << 32) | ((uint64_t)(unsigned int)to) |
+         ((uint64_t)mode << 63);
+}
+
+inline std::vector<Vector2> Navigator::toWorld(const NavGrid &grid,
+                                               const std::vector<int> &cells,
+                                               Vector2 from, Vector2 to) {
+  std::vector<Vector2> path;
+  path.reserve(cells.size());
+  for (int c : cells)
+    path.push_back(grid.center(c));
+
+  // Start and end exactly, where asked for
+  if (!path.empty()) {
+    path.front() = from;
+    path.back() = to;
+  }
+  return path;
+}
+
+inline void Navigator::remember(uint64_t key, const Result &r) {
+  auto found = _cache.find(key);
+  if (found != _cache.end()) {
+    _lru.erase(found->second.lru);
+    _cache.erase(found);
+  }
+
+  if (_cache.size() >= NAV_PATH_CACHE) {
+    _cache.erase(_lru.back());
+    _lru.pop_back();
+  }
+
+  int cols = _grid->cols;
+  CachedPath cp;
+  cp.cells = r.cells;
+  cp.found = r.found;
+  cp.area = {INT_MAX, INT_MAX, -1, -1};
+  for (int c : r.cells) {
+    cp.area.x0 = std::min(cp.area.x0, c % cols);
+    cp.area.y0 = std::min(cp.area.y0, c / cols);
+    cp.area.x1 = std::max(cp.area.x1, c % cols);
+    cp.area.y1 = std::max(cp.area.y1, c / cols);
+  }
+
+  _lru.push_front(key);
+  cp.lru = _lru.begin();
+  _cache[key] = cp;
+}
+
+// Waypoints are connected by straight or diagonal lines; checks each cell
+// on the way
+inline bool Navigator::crossesBlocked(const NavGrid &grid,
+                                      const std::vector<int> &cells) {
+  for (size_t a = 1; a < cells.size(); a++) {
+    int x = cells[a - 1] % grid.cols, y = cells[a - 1] / grid.cols;
+    int tx = cells[a] % grid.cols, ty = cells[a] / grid.cols;
+    int dx = (tx > x) - (tx < x), dy = (ty > y) - (ty < y);
+
+    while (x != tx || y != ty) {
+      x += dx;
+      y += dy;
+      if (!grid.walkable(x, y))
+        return true;
+    }
+  }
+  return false;
+}
+
+inline void Navigator::submit(Play p) {
+  if (_queued.empty())
+    return;
+
+  std::shared_ptr<const NavGrid> grid = _grid;
+  std::vector<Search> batch;
+
+  for (Request &r : _queued) {
+    int from = grid->cellAt(r.from);
+    int to = grid->cellAt(r.to);
+    r.key = keyOf(from, to, r.mode);
+    _inFlight[r.id] = r;
+
+    // Someone already asked for the same path: wait for the same search
+    auto waiting = _waiting.find(r.key);
+    if (waiting != _waiting.end()) {
+      waiting->second.push_back(r.id);
+      continue;
+    }
+    _waiting[r.key].push_back(r.id);
+
+    // Known path: handed out with the next results
+    auto cached = _cache.find(r.key);
+    if (cached != _cache.end()) {
+      _lru.erase(cached->second.lru);
+      _lru.push_front(r.key);
+      cached->second.lru = _lru.begin();
+
+      Result res = {r.key, grid->version, cached->second.found,
+                    cached->second.cells};
+      std::lock_guard<std::mutex> lock(_inbox->mutex);
+      _inbox->results.push_back(res);
+      continue;
+    }
+
+    Search sr = {r.key, from, to, r.mode};
+    batch.push_back(sr);
+  }
+  _queued.clear();
+
+  // A few searches per job, so the pool isn't flooded with tiny jobs
+  std::shared_ptr<Inbox> inbox = _inbox;
+  for (size_t first = 0; first < batch.size(); first += NAV_REQUESTS_PER_JOB) {
+    size_t last = std::min(batch.size(), first + NAV_REQUESTS_PER_JOB);
+    std::vector<Search> part(batch.begin() + first, batch.begin() + last);
+
+    auto job = [grid, inbox, part]() {
+      std::vector<Result> results(part.size());
+      for (size_t a = 0; a < part.size(); a++) {
+        Result &r = results[a];
+        r.key = part[a].key;
+        r.version = grid->version;
+        search(*grid, part[a].from, part[a].to, part[a].mode, r);
+      }
+
+      std::lock_guard<std::mutex> lock(inbox->mutex);
+      for (Result &r : results)
+        inbox->results.push_back(std::move(r));
+    };
+
+    // Headless, each path arrives exactly one tick after it was asked for,
+    // so replays don't depend on the workers timing
+    if (p.stage->IsHeadless())
+      job();
+    else
+      p.stage->Workers().Run(job);
+  }
+}
+
+inline void Navigator::deliver() {
+  std::vector<Result> results;
+  {
+    std::lock_guard<std::mutex> lock(_inbox->mutex);
+    results.swap(_inbox->results);
+  }
+
+  for (Result &r : results) {
+    auto waiting = _waiting.find(r.key);
+    if (waiting == _waiting.end())
+      continue;
+
+    std::vector<PathRequest> ids;
+    ids.swap(waiting->second);
+    _waiting.erase(waiting);
+
+    // Searched on an older grid: search again, if the path got blocked
+    bool stale = r.version != _grid->version && r.found &&
+                 crossesBlocked(*_grid, r.cells);
+
+    if (!stale && r.version == _grid->version && _cache.count(r.key) == 0)
+      remember(r.key, r);
+
+    for (PathRequest id : ids) {
+      auto found = _inFlight.find(id);
+      if (found == _inFlight.end())
+        continue; // cancelled
+
+      Request req = found->second;
+      _inFlight.erase(found);
+
+      if (stale) {
+        _queued.push_back(req);
+        continue;
+      }
+
+      if (req.done)
+        req.done(req.id, r.found ? toWorld(*_grid, r.cells, req.from, req.to)
+                                 : std::vector<Vector2>());
+    }
+  }
+}
+
+inline void Navigator::OnStageEnter(Play p) { _workers = &p.stage->Workers(); }
+
+inline void Navigator::OnStageLeave(Play) { _workers = NULL; }
+
+inline void Navigator::OnTick(Play p) {
+  if (!_dirty.empty())
+    rebuild();
+
+  deliver();
+  submit(p);
+}
+
+// BM: Navigator - Implementation - Search
+//------------------------------------------------------------------------------
+// Moves are straight or diagonal; diagonal moves may not cut corners.
+// Both modes find equally short paths, JPS only looks at fewer cells.
+
+// Per thread memory of the searches, reused across searches
+struct NavWorkspace {
+  std::vector<float> cost;
+  std::vector<int> parent;
+  std::vector<unsigned int> seen;   // == stamp: cost and parent are valid
+  std::vector<unsigned int> closed; // == stamp: done with the cell
+  unsigned int stamp = 0;
+
+  void prepare(size_t cells) {
+    if (seen.size() != cells) {
+      cost.assign(cells, 0);
+      parent.assign(cells, -1);
+      seen.assign(cells, 0);
+      closed.assign(cells, 0);
+      stamp = 0;
+    }
+
+    // Once the stamp wraps around, old stamps could match again
+    if (++stamp == 0) {
+      std::fill(seen.begin(), seen.end(), 0);
+      std::fill(closed.begin(), closed.end(), 0);
+      stamp = 1;
+    }
+  }
+};
+
+inline float navDistance(int dx, int dy) {
+  dx = std::abs(dx);
+  dy = std::abs(dy);
+  return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+}
+
+inline void Navigator::search(const NavGrid &grid, int from, int to,
+                              PathMode mode, Result &out) {
+  out.found = false;
+  out.cells.clear();
+  if (from < 0 || to < 0 || grid.blocked[to] != 0)
+    return;
+
+  if (from == to) {
+    out.found = true;
+    out.cells.push_back(from);
+    out.cells.push_back(to);
+    return;
+  }
+
+  static thread_local NavWorkspace ws;
+  ws.prepare(grid.blocked.size());
+  unsigned int stamp = ws.stamp;
+
+  int cols = grid.cols;
+  int tx = to % cols, ty = to / cols;
+
+  typedef std::pair<float, int> Open; // f, cell
+  std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+
+  ws.cost[from] = 0;
+  ws.parent[from] = -1;
+  ws.seen[from] = stamp;
+  open.push({navDistance(from % cols - tx, from / cols - ty), from});
+
+  int neighbors[8];
+  while (!open.empty()) {
+    int cell = open.top().second;
+    open.pop();
+
+    if (ws.closed[cell] == stamp)
+      continue;
+    ws.closed[cell] = stamp;
+
+    if (cell == to)
+      break;
+
+    int x = cell % cols, y = cell / cols;
+    int cnt = 0;
+
+    // The directions to look into
+    int par = ws.parent[cell];
+    if (mode == PATH_JPS && par >= 0) {
+      int dx = (x > par % cols) - (x < par % cols);
+      int dy = (y > par / cols) - (y < par / cols);
+
+      if (dx != 0 && dy != 0) {
+        bool nx = grid.walkable(x + dx, y), ny = grid.walkable(x, y + dy);
+        if (ny)
+          neighbors[cnt++] = (y + dy) * cols + x;
+        if (nx)
+          neighbors[cnt++] = y * cols + x + dx;
+        if (nx && ny)
+          neighbors[cnt++] = (y + dy) * cols + x + dx;
+      } else if (dx != 0) {
+        bool next = grid.walkable(x + dx, y);
+        bool up = grid.walkable(x, y - 1), down = grid.walkable(x, y + 1);
+        if (next) {
+          neighbors[cnt++] = y * cols + x + dx;
+          if (up)
+            neighbors[cnt++] = (y - 1) * cols + x + dx;
+          if (down)
+            neighbors[cnt++] = (y + 1) * cols + x + dx;
+        }
+        if (up)
+          neighbors[cnt++] = (y - 1) * cols + x;
+        if (down)
+          neighbors[cnt++] = (y + 1) * cols + x;
+      } else {
+        bool next = grid.walkable(x, y + dy);
+        bool left = grid.walkable(x - 1, y), right = grid.walkable(x + 1, y);
+        if (next) {
+          neighbors[cnt++] = (y + dy) * cols + x;
+          if (left)
+            neighbors[cnt++] = (y + dy) * cols + x - 1;
+          if (right)
+            neighbors[cnt++] = (y + dy) * cols + x + 1;
+        }
+        if (left)
+          neighbors[cnt++] = y * cols + x - 1;
+        if (right)
+          neighbors[cnt++] = y * cols + x + 1;
+      }
+    } else {
+      for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++) {
+          if ((dx == 0 && dy == 0) || !grid.walkable(x + dx, y + dy))
+            continue;
+          if (dx != 0 && dy != 0 &&
+              (!grid.walkable(x + dx, y) || !grid.walkable(x, y + dy)))
+            continue;
+          neighbors[cnt++] = (y + dy) * cols + x + dx;
+        }
+    }
+
+    for (int n = 0; n < cnt; n++) {
+      int next = neighbors[n];
+      if (mode == PATH_JPS) {
+        int nx = next % cols, ny = next / cols;
+        next = jump(grid, nx, ny, nx - x, ny - y, to);
+        if (next < 0)
+          continue;
+      }
+
+      if (ws.closed[next] == stamp)
+        continue;
+
+      int nx = next % cols, ny = next / cols;
+      float cost = ws.cost[cell] + navDistance(nx - x, ny - y);
+      if (ws.seen[next] == stamp && ws.cost[next] <= cost)
+        continue;
+
+      ws.seen[next] = stamp;
+      ws.cost[next] = cost;
+      ws.parent[next] = cell;
+      open.push({cost + navDistance(nx - tx, ny - ty), next});
+    }
+  }
+
+  if (ws.closed[to] != stamp)
+    return;
+
+  for (int c = to; c >= 0; c = ws.parent[c])
+    out.cells.push_back(c);
+  std::reverse(out.cells.begin(), out.cells.end());
+
+  // Only keep the cells, where the path changes direction
+  if (out.cells.size() > 2) {
+    std::vector<int> turns;
+    turns.push_back(out.cells[0]);
+    for (size_t a = 1; a + 1 < out.cells.size(); a++) {
+      int p = out.cells[a - 1], c = out.cells[a], n = out.cells[a + 1];
+      int dx1 = (c % cols > p % cols) - (c % cols < p % cols);
+      int dy1 = (c / cols > p / cols) - (c / cols < p / cols);
+      int dx2 = (n % cols > c % cols) - (n % cols < c % cols);
+      int dy2 = (n / cols > c / cols) - (n / cols < c / cols);
+      if (dx1 != dx2 || dy1 != dy2)
+        turns.push_back(c);
+    }
+    turns.push_back(out.cells.back());
+    out.cells.swap(turns);
+  }
+  out.found = true;
+}
+
+// Walks from (x, y) into the direction, until there is a reason to stop
+// @return the cell to stop at (-1 = blocked)
+inline int Navigator::jump(const NavGrid &grid, int x, int y, int dx, int dy,
+                           int goal) {
+  if (dx == 0 || dy == 0)
+    return jumpStraight(grid, x, y, dx, dy, goal);
+
+  while (grid.walkable(x, y)) {
+    int cell = y * grid.cols + x;
+    if (cell == goal)
+      return cell;
+
+    // Something worth a look to the side
+    if (jumpStraight(grid, x + dx, y, dx, 0, goal) >= 0 ||
+        jumpStraight(grid, x, y + dy, 0, dy, goal) >= 0)
+      return cell;
+
+    // Diagonal moves may not cut corners
+    if (!grid.walkable(x + dx, y) || !grid.walkable(x, y + dy))
+      return -1;
+
+    x += dx;
+    y += dy;
+  }
+  return -1;
+}
+
+inline int Navigator::jumpStraight(const NavGrid &grid, int x, int y, int dx,
+                                   int dy, int goal) {
+  while (grid.walkable(x, y)) {
+    int cell = y * grid.cols + x;
+    if (cell == goal)
+      return cell;
+
+    // A wall ends next to us: the path may turn around its corner here
+    if (dx != 0) {
+      if ((grid.walkable(x, y - 1) && !grid.walkable(x - dx, y - 1)) ||
+          (grid.walkable(x, y + 1) && !grid.walkable(x - dx, y + 1)))
+        return cell;
+    } else {
+      if ((grid.walkable(x - 1, y) && !grid.walkable(x - 1, y - dy)) ||
+          (grid.walkable(x + 1, y) && !grid.walkable(x + 1, y - dy)))
+        return cell;
+    }
+
+    x += dx;
+    y += dy;
+  }
+  return -1;
+}
+
+// BM: Navigator - Implementation - Flow fields
+//------------------------------------------------------------------------------
+// Fields are integrated with Dijkstra, tile by tile: each round solves all
+// active tiles in parallel (reading their neighbors as of the last round),
+// then wakes the neighbors of tiles, that changed. This repeats, until no
+// tile changes anymore.
+
+inline std::shared_ptr<const FlowField> Navigator::GetFlowField(Vector2 goal) {
+  if (!_dirty.empty())
+    rebuild();
+
+  int cell = _grid->cellAt(goal);
+  auto found = _fields.find(cell);
+  if (found != _fields.end()) {
+    _fieldLru.erase(found->second->_lru);
+    _fieldLru.push_front(cell);
+    found->second->_lru = _fieldLru.begin();
+    return found->second;
+  }
+
+  if (_fields.size() >= NAV_FLOW_FIELDS) {
+    _fields.erase(_fieldLru.back());
+    _fieldLru.pop_back();
+  }
+
+  std::shared_ptr<FlowField> f(new FlowField());
+  const NavGrid &g = *_grid;
+  f->_grid = _grid;
+  f->_goal = cell;
+  f->_version = 0;
+  f->_tilesX = (g.cols + NAV_FLOW_TILE - 1) / NAV_FLOW_TILE;
+  f->_tilesY = (g.rows + NAV_FLOW_TILE - 1) / NAV_FLOW_TILE;
+  f->_cost.assign(g.blocked.size(), INFINITY);
+  f->_step.assign(g.blocked.size(), 8);
+
+  if (cell >= 0 && g.blocked[cell] == 0) {
+    f->_cost[cell] = 0;
+    int tile = (cell / g.cols / NAV_FLOW_TILE) * f->_tilesX +
+               cell % g.cols / NAV_FLOW_TILE;
+    solveFlow(*f, std::vector<int>(1, tile));
+  }
+
+  _fieldLru.push_front(cell);
+  f->_lru = _fieldLru.begin();
+  _fields[cell] = f;
+  return f;
+}
+
+inline unsigned int Navigator::FlowFieldCount() { return _fields.size(); }
+
+inline bool Navigator::canStep(const NavGrid &grid, int x, int y, int step) {
+  int dx = NavStepX[step], dy = NavStepY[step];
+  if (!grid.walkable(x + dx, y + dy))
+    return false;
+  return dx == 0 || dy == 0 ||
+         (grid.walkable(x + dx, y) && grid.walkable(x, y + dy));
+}
+
+// Fixes the field after the cells in _dirty changed
+inline void Navigator::repairFlow(FlowField &f, const NavGrid &old) {
+  const NavGrid &g = *_grid;
+  f._grid = _grid;
+  f._version++;
+
+  int goal = f._goal;
+  if (goal < 0)
+    return;
+
+  // The goal itself changed: start over
+  if (g.blocked[goal] != 0 || old.blocked[goal] != 0) {
+    std::fill(f._cost.begin(), f._cost.end(), INFINITY);
+    std::fill(f._step.begin(), f._step.end(), 8);
+    if (g.blocked[goal] == 0) {
+      f._cost[goal] = 0;
+      int tile = (goal / g.cols / NAV_FLOW_TILE) * f._tilesX +
+                 goal % g.cols / NAV_FLOW_TILE;
+      solveFlow(f, std::vector<int>(1, tile));
+    }
+    return;
+  }
+
+  int cols = g.cols;
+  auto tileOf = [&f, cols](int cell) {
+    return (cell / cols / NAV_FLOW_TILE) * f._tilesX +
+           cell % cols / NAV_FLOW_TILE;
+  };
+
+  // Cells, that now lead through a blocked cell (or cut its corner), lose
+  // their way; and so do all cells leading through them
+  std::vector<int> lost;
+  std::vector<int> tiles;
+  for (const CellArea &d : _dirty)
+    for (int y = d.y0; y <= d.y1; y++)
+      for (int x = d.x0; x <= d.x1; x++) {
+        int c = y * cols + x;
+        if (g.blocked[c] == old.blocked[c])
+          continue;
+
+        tiles.push_back(tileOf(c));
+        if (g.blocked[c] == 0)
+          continue; // freed: may only shorten ways
+
+        lost.push_back(c);
+        for (int s = 0; s < 8; s += 2) {
+          int nx = x - NavStepX[s], ny = y - NavStepY[s];
+          if (nx < 0 || ny < 0 || nx >= cols || ny >= g.rows)
+            continue;
+
+          int n = ny * cols + nx;
+          int st = f._step[n];
+          if (st != 8 && st % 2 == 1 &&
+              ((nx + NavStepX[st] == x && ny == y) ||
+               (nx == x && ny + NavStepY[st] == y)))
+            lost.push_back(n);
+        }
+      }
+
+  for (size_t a = 0; a < lost.size(); a++) {
+    int c = lost[a];
+    if (f._cost[c] == INFINITY)
+      continue;
+    f._cost[c] = INFINITY;
+    f._step[c] = 8;
+    tiles.push_back(tileOf(c));
+
+    int x = c % cols, y = c / cols;
+    for (int s = 0; s < 8; s++) {
+      int nx = x + NavStepX[s], ny = y + NavStepY[s];
+      if (nx < 0 || ny < 0 || nx >= cols || ny >= g.rows)
+        continue;
+
+      int n = ny * cols + nx;
+      int st = f._step[n];
+      if (st != 8 && nx + NavStepX[st] == x && ny + NavStepY[st] == y)
+        lost.push_back(n);
+    }
+  }
+
+  solveFlow(f, tiles);
+}
+
+inline void Navigator::solveFlow(FlowField &f, std::vector<int> tiles) {
+  const int T = NAV_FLOW_TILE;
+  int tileCnt = f._tilesX * f._tilesY;
+
+  std::vector<unsigned int> queued(tileCnt, 0);
+  std::vector<unsigned char> changed(tileCnt, 0);
+  unsigned int round = 1;
+
+  // Only solve each tile once per round
+  std::vector<int> active;
+  for (int t : tiles)
+    if (queued[t] != round) {
+      queued[t] = round;
+      active.push_back(t);
+      changed[t] = 1; // its directions need a look in any case
+    }
+
+  std::vector<float> buffers;
+  std::vector<unsigned char> improved;
+  while (!active.empty()) {
+    buffers.resize(active.size() * T * T);
+    improved.assign(active.size(), 0);
+
+    const FlowField &field = f;
+    auto job = [&field, &active, &buffers, &improved](size_t b, size_t e) {
+      for (size_t a = b; a < e; a++)
+        improved[a] = solveTile(field, active[a], &buffers[a * T * T]);
+    };
+    if (_workers != NULL && active.size() > 1)
+      _workers->ParallelFor(active.size(), 1, job);
+    else
+      job(0, active.size());
+
+    // Take over the new costs, and wake the neighbors
+    round++;
+    std::vector<int> next;
+    for (size_t a = 0; a < active.size(); a++) {
+      if (!improved[a])
+        continue;
+
+      int t = active[a];
+      int tx = t % f._tilesX, ty = t / f._tilesX;
+      int x0 = tx * T, y0 = ty * T;
+      int x1 = std::min(x0 + T, f._grid->cols);
+      int y1 = std::min(y0 + T, f._grid->rows);
+      for (int y = y0; y < y1; y++)
+        std::copy(&buffers[a * T * T + (y - y0) * T],
+                  &buffers[a * T * T + (y - y0) * T] + (x1 - x0),
+                  &f._cost[y * f._grid->cols + x0]);
+      changed[t] = 1;
+
+      for (int s = 0; s < 8; s++) {
+        int nx = tx + NavStepX[s], ny = ty + NavStepY[s];
+        if (nx < 0 || ny < 0 || nx >= f._tilesX || ny >= f._tilesY)
+          continue;
+
+        int n = ny * f._tilesX + nx;
+        if (queued[n] != round) {
+          queued[n] = round;
+          next.push_back(n);
+        }
+      }
+    }
+    active.swap(next);
+  }
+
+  // Directions depend on the costs next to them, so the neighbors of changed
+  // tiles need new ones, too
+  std::vector<int> dirty;
+  round++;
+  for (int t = 0; t < tileCnt; t++) {
+    if (!changed[t])
+      continue;
+
+    int tx = t % f._tilesX, ty = t / f._tilesX;
+    for (int s = 0; s < 9; s++) {
+      int nx = tx + NavStepX[s], ny = ty + NavStepY[s];
+      if (nx < 0 || ny < 0 || nx >= f._tilesX || ny >= f._tilesY)
+        continue;
+
+      int n = ny * f._tilesX + nx;
+      if (queued[n] != round) {
+        queued[n] = round;
+        dirty.push_back(n);
+      }
+    }
+  }
+  flowDirections(f, dirty);
+}
+
+// Dijkstra within one tile, starting from the costs of the cells around it
+// @return true = a cell of the tile got cheaper
+inline bool Navigator::solveTile(const FlowField &f, int tile, float *out) {
+  const NavGrid &g = *f._grid;
+  const int T = NAV_FLOW_TILE;
+  int x0 = tile % f._tilesX * T, y0 = tile / f._tilesX * T;
+  int x1 = std::min(x0 + T, g.cols), y1 = std::min(y0 + T, g.rows);
+
+  typedef std::pair<float, int> Open; // cost, cell within the tile
+  std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+
+  for (int y = y0; y < y1; y++)
+    for (int x = x0; x < x1; x++) {
+      int i = (y - y0) * T + (x - x0);
+      out[i] = f._cost[y * g.cols + x];
+      if (g.blocked[y * g.cols + x] != 0)
+        continue;
+
+      for (int s = 0; s < 8; s++) {
+        int nx = x + NavStepX[s], ny = y + NavStepY[s];
+        if ((nx >= x0 && nx < x1 && ny >= y0 && ny < y1) ||
+            !canStep(g, x, y, s))
+          continue;
+        out[i] = std::min(out[i],
+                          f._cost[ny * g.cols + nx] + NavStepLength[s]);
+      }
+
+      if (out[i] != INFINITY)
+        open.push({out[i], i});
+    }
+
+  while (!open.empty()) {
+    float cost = open.top().first;
+    int i = open.top().second;
+    open.pop();
+    if (cost > out[i])
+      continue;
+
+    int x = x0 + i % T, y = y0 + i / T;
+    for (int s = 0; s < 8; s++) {
+      int nx = x + NavStepX[s], ny = y + NavStepY[s];
+      if (nx < x0 || nx >= x1 || ny < y0 || ny >= y1 || !canStep(g, x, y, s))
+        continue;
+
+      int n = (ny - y0) * T + (nx - x0);
+      float next = cost + NavStepLength[s];
+      if (next < out[n]) {
+        out[n] = next;
+        open.push({next, n});
+      }
+    }
+  }
+
+  // Float sums may differ in the last bits, only count real improvements
+  for (int y = y0; y < y1; y++)
+    for (int x = x0; x < x1; x++)
+      if (out[(y - y0) * T + (x - x0)] < f._cost[y * g.cols + x] - 1e-4f)
+        return true;
+  return false;
+}
+
+// Points each cell of the tiles to its cheapest neighbor
+inline void Navigator::flowDirections(FlowField &f,
+                                      const std::vector<int> &tiles) {
+  FlowField &field = f;
+  auto job = [&field, &tiles](size_t b, size_t e) {
+    const NavGrid &g = *field._grid;
+    const int T = NAV_FLOW_TILE;
+
+    for (size_t a = b; a < e; a++) {
+      int x0 = tiles[a] % field._tilesX * T, y0 = tiles[a] / field._tilesX * T;
+      int x1 = std::min(x0 + T, g.cols), y1 = std::min(y0 + T, g.rows);
+
+      for (int y = y0; y < y1; y++)
+        for (int x = x0; x < x1; x++) {
+          int c = y * g.cols + x;
+          unsigned char best = 8;
+          float bestCost = field._cost[c];
+
+          if (c != field._goal && bestCost != INFINITY)
+            for (int s = 0; s < 8; s++) {
+              if (!canStep(g, x, y, s))
+                continue;
+              float cost = field._cost[c + NavStepY[s] * g.cols + NavStepX[s]] +
+                           NavStepLength[s];
+              if (best == 8 || cost < bestCost) {
+                best = s;
+                bestCost = cost;
+              }
+            }
+
+          field._step[c] = best;
+        }
+    }
+  };
+
+  if (_workers != NULL && tiles.size() > 1)
+    _workers->ParallelFor(tiles.size(), 1, job);
+  else
+    job(0, tiles.size());
+}
+
+// BM: FlowField - Implementation
+//==============================================================================
+inline int FlowField::cellAt(Vector2 loc) const { return _grid->cellAt(loc); }
+
+inline Vector2 FlowField::Direction(Vector2 loc) const {
+  int cell = cellAt(loc);
+  if (cell < 0)
+    return {0, 0};
+  return NavStepDirection[_step[cell]];
+}
+
+inline float FlowField::Distance(Vector2 loc) const {
+  int cell = cellAt(loc);
+  if (cell < 0)
+    return INFINITY;
+  return _cost[cell] * _grid->cellSize;
+}
+
+inline bool FlowField::Reachable(Vector2 loc) const {
+  int cell = cellAt(loc);
+  return cell >= 0 && _cost[cell] != INFINITY;
+}
+
+inline Vector2 FlowField::Goal() const {
+  return _goal >= 0 ? _grid->center(_goal) : Vector2{0, 0};
+}
+
+inline unsigned int FlowField::Version() const { return _version; }
+
+} // namespace Theater
+
+#endif // RayTheaterNavigation_H
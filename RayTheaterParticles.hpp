@@ -0,0 +1,320 @@
+#ifndef RayTheaterParticles_H
+#define RayTheaterParticles_H 1
+
+#include <algorithm>
+#include <cmath>
+#include <raylib.h>
+#include <rlgl.h>
+#include <vector>
+
+#include "RayTheater.hpp"
+
+namespace Theater {
+
+// Particles per emitter, from which on the update is split across the
+// Stages WorkerPool (if enabled with ParticleEmitter::Threaded)
+#ifndef PARTICLES_PER_THREAD
+#define PARTICLES_PER_THREAD 16384
+#endif
+
+// BM: ParticleEmitter - Class
+//==============================================================================
+/** @brief An Actor, that spawns, moves and draws thousands of small
+ * particles. The particles are no Actors themself, they are stored in one
+ * array per value, updated in tight loops, the compiler can vectorize, and
+ * drawn as one batch of quads.
+ *
+ * The emitter spawns at its Transform2D location (including its parents).
+ * Spawned particles move on their own, in Stage coordinates.
+ */
+class ParticleEmitter : public Actor,
+                        public Visible,
+                        public Ticking,
+                        public Transform2D {
+public:
+  struct Settings {
+    /** @brief particles spawned per second */
+    float rate = 100;
+
+    /** @brief seconds, a particle lives (random between min and max) */
+    float lifetimeMin = 1;
+    float lifetimeMax = 2;
+
+    /** @brief pixels per second, a particle starts with */
+    float speedMin = 20;
+    float speedMax = 60;
+
+    /** @brief direction particles are spawned in, and how far (both in
+     * degrees) they may deviate from it */
+    float angle = -90;
+    float spread = 360;
+
+    /** @brief change in velocity per second (e.g. gravity) */
+    Vector2 acceleration = {0, 0};
+
+    /** @brief size in pixels, at the start and the end of a particles life */
+    float sizeStart = 4;
+    float sizeEnd = 0;
+
+    /** @brief color at the start and the end of a particles life */
+    Color colorStart = WHITE;
+    Color colorEnd = {255, 255, 255, 0};
+
+    /** @brief texture of each particle (empty = plain squares) */
+    Texture2D texture = {};
+  };
+
+  /** @param capacity - max number of particles alive at the same time */
+  ParticleEmitter(unsigned int capacity);
+
+  ParticleEmitter *Setup(Settings s);
+
+  /** @brief starts or stops spawning particles over time */
+  ParticleEmitter *Emitting(bool on);
+
+  /** @brief spawns count particles right away */
+  ParticleEmitter *Burst(unsigned int count);
+
+  /** @brief updates the particles on the Stages WorkerPool, once there are
+   * more than PARTICLES_PER_THREAD */
+  ParticleEmitter *Threaded(bool on);
+
+  /** @brief seeds the emitters random numbers (same seed = same particles) */
+  ParticleEmitter *Seed(unsigned int seed);
+
+  /** @brief removes all particles */
+  void Clear();
+
+  /** @return number of particles alive */
+  unsigned int Count();
+
+  unsigned int Capacity();
+
+private:
+  Settings _settings;
+  bool _emitting;
+  bool _threaded;
+  float _spawnDebt;
+  unsigned int _random;
+
+  // The particles, one array per value. Only the first _count are alive
+  unsigned int _count;
+  unsigned int _capacity;
+  std::vector<float> _x;
+  std::vector<float> _y;
+  std::vector<float> _vx;
+  std::vector<float> _vy;
+  std::vector<float> _age;     // 0 = spawned, 1 = dead
+  std::vector<float> _ageRate; // 1 / lifetime
+
+  // Helpers
+  //----------------------------------------------------------------------------
+  float random01();
+  void spawn(unsigned int count);
+  void compact();
+
+  static void integrate(float *__restrict x, float *__restrict y,
+                        float *__restrict vx, float *__restrict vy,
+                        float *__restrict age,
+                        const float *__restrict ageRate, size_t begin,
+                        size_t end, Vector2 acc, float dt);
+
+  // Interfaces
+  //----------------------------------------------------------------------------
+public:
+  // Implement - Visible
+  //----------------------------------------------------------------------------
+  void OnDraw(Play) override;
+
+  // Implement - Ticking
+  //----------------------------------------------------------------------------
+  void OnTick(Play) override;
+};
+
+// BM: ParticleEmitter - Implementation
+//==============================================================================
+inline ParticleEmitter::ParticleEmitter(unsigned int capacity)
+    : Actor(), Visible(this), Ticking(this), Transform2D(this), _settings(),
+      _emitting(true), _threaded(false), _spawnDebt(0), _random(0x9E3779B9),
+      _count(0), _capacity(capacity), _x(capacity), _y(capacity),
+      _vx(capacity), _vy(capacity), _age(capacity), _ageRate(capacity) {}
+
+inline ParticleEmitter *ParticleEmitter::Setup(Settings s) {
+  _settings = s;
+  return this;
+}
+
+inline ParticleEmitter *ParticleEmitter::Emitting(bool on) {
+  _emitting = on;
+  if (!on)
+    _spawnDebt = 0;
+  return this;
+}
+
+inline ParticleEmitter *ParticleEmitter::Burst(unsigned int count) {
+  spawn(count);
+  return this;
+}
+
+inline ParticleEmitter *ParticleEmitter::Threaded(bool on) {
+  _threaded = on;
+  return this;
+}
+
+inline ParticleEmitter *ParticleEmitter::Seed(unsigned int seed) {
+  // xorshift must not start at 0
+  _random = seed != 0 ? seed : 0x9E3779B9;
+  return this;
+}
+
+inline void ParticleEmitter::Clear() { _count = 0; }
+
+inline unsigned int ParticleEmitter::Count() { return _count; }
+
+inline unsigned int ParticleEmitter::Capacity() { return _capacity; }
+
+inline float ParticleEmitter::random01() {
+  _random ^= _random << 13;
+  _random ^= _random >> 17;
+  _random ^= _random << 5;
+  return (_random >> 8) * (1.0f / 16777216.0f);
+}
+
+inline void ParticleEmitter::spawn(unsigned int count) {
+  count = std::min(count, _capacity - _count);
+
+  Vector2 origin = getWorldLoc();
+  const Settings &s = _settings;
+
+  for (unsigned int a = 0; a < count; a++) {
+    unsigned int i = _count++;
+
+    float angle = (s.angle + (random01() - 0.5f) * s.spread) * DEG2RAD;
+    float speed = s.speedMin + random01() * (s.speedMax - s.speedMin);
+    float lifetime =
+        s.lifetimeMin + random01() * (s.lifetimeMax - s.lifetimeMin);
+
+    _x[i] = origin.x;
+    _y[i] = origin.y;
+    _vx[i] = std::cos(angle) * speed;
+    _vy[i] = std::sin(angle) * speed;
+    _age[i] = 0;
+    _ageRate[i] = lifetime > 0 ? 1.0f / lifetime : 1e9f;
+  }
+}
+
+// Moves the last particles into the slots of dead ones
+inline void ParticleEmitter::compact() {
+  unsigned int a = 0;
+  while (a < _count) {
+    if (_age[a] < 1.0f) {
+      a++;
+      continue;
+    }
+
+    _count--;
+    _x[a] = _x[_count];
+    _y[a] = _y[_count];
+    _vx[a] = _vx[_count];
+    _vy[a] = _vy[_count];
+    _age[a] = _age[_count];
+    _ageRate[a] = _ageRate[_count];
+  }
+}
+
+// Plain loop over separate arrays, so the compiler can vectorize it
+inline void ParticleEmitter::integrate(float *__restrict x, float *__restrict y,
+                                       float *__restrict vx,
+                                       float *__restrict vy,
+                                       float *__restrict age,
+                                       const float *__restrict ageRate,
+                                       size_t begin, size_t end, Vector2 acc,
+                                       float dt) {
+  float dvx = acc.x * dt;
+  float dvy = acc.y * dt;
+
+  for (size_t i = begin; i < end; i++) {
+    vx[i] += dvx;
+    vy[i] += dvy;
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+    age[i] += ageRate[i] * dt;
+  }
+}
+
+inline void ParticleEmitter::OnTick(Play p) {
+  float dt = p.deltaTime;
+  Vector2 acc = _settings.acceleration;
+
+  if (_threaded && _count > PARTICLES_PER_THREAD) {
+    p.stage->Workers().ParallelFor(
+        _count, PARTICLES_PER_THREAD, [this, acc, dt](size_t b, size_t e) {
+          integrate(_x.data(), _y.data(), _vx.data(), _vy.data(),
+                    _age.data(), _ageRate.data(), b, e, acc, dt);
+        });
+  } else {
+    integrate(_x.data(), _y.data(), _vx.data(), _vy.data(), _age.data(),
+              _ageRate.data(), 0, _count, acc, dt);
+  }
+
+  compact();
+
+  if (_emitting) {
+    _spawnDebt += _settings.rate * dt;
+    unsigned int spawns = (unsigned int)_spawnDebt;
+    _spawnDebt -= spawns;
+    spawn(spawns);
+  }
+}
+
+inline void ParticleEmitter::OnDraw(Play p) {
+  if (_count == 0)
+    return;
+
+  const Settings &s = _settings;
+  unsigned int texture =
+      s.texture.id != 0 ? s.texture.id : rlGetTextureIdDefault();
+
+  float sizeDelta = s.sizeEnd - s.sizeStart;
+  float r = s.colorStart.r, dr = s.colorEnd.r - r;
+  float g = s.colorStart.g, dg = s.colorEnd.g - g;
+  float b = s.colorStart.b, db = s.colorEnd.b - b;
+  float a = s.colorStart.a, da = s.colorEnd.a - a;
+
+  // Quads are sent in chunks, that fit into RayLibs render batch
+  const unsigned int chunk = 1024;
+  for (unsigned int first = 0; first < _count; first += chunk) {
+    unsigned int last = std::min(_count, first + chunk);
+    rlCheckRenderBatchLimit((last - first) * 4);
+
+    rlSetTexture(texture);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+
+    for (unsigned int i = first; i < last; i++) {
+      float t = _age[i];
+      float half = (s.sizeStart + sizeDelta * t) * 0.5f;
+      float x = _x[i];
+      float y = _y[i];
+
+      rlColor4ub((unsigned char)(r + dr * t), (unsigned char)(g + dg * t),
+                 (unsigned char)(b + db * t), (unsigned char)(a + da * t));
+
+      rlTexCoord2f(0.0f, 0.0f);
+      rlVertex2f(x - half, y - half);
+      rlTexCoord2f(0.0f, 1.0f);
+      rlVertex2f(x - half, y + half);
+      rlTexCoord2f(1.0f, 1.0f);
+      rlVertex2f(x + half, y + half);
+      rlTexCoord2f(1.0f, 0.0f);
+      rlVertex2f(x + half, y - half);
+    }
+
+    rlEnd();
+    rlSetTexture(0);
+  }
+}
+
+} // namespace Theater
+
+#endif // RayTheaterParticles_H
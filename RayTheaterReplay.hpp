@@ -0,0 +1,454 @@
+#ifndef RayTheaterReplay_H
+#define RayTheaterReplay_H 1
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+#include "RayTheater.hpp"
+
+namespace Theater {
+
+// BM: Replay - Format
+//==============================================================================
+// A recording starts with a header:
+//   'R' 'T' 'I' 'R' | version (1 byte) | seed (4 bytes, little endian)
+//
+// followed by one entry per cycle. Each entry starts with a flags-byte, that
+// tells which values changed since the last cycle. Only changed values follow.
+// Floats are stored as the XOR of their bits with the previous value, bytes are
+// stored as is. Runs of unchanged cycles are collapsed into a single
+// REPLAY_REPEAT entry.
+//
+// A REPLAY_SCENE_SWITCH entry stands for no cycle: it marks, that a pending
+// Scene transition happened before the next cycles input.
+#define RAYTHEATER_REPLAY_VERSION 2
+
+enum ReplayFlags {
+  REPLAY_DELTATIME = 1 << 0,
+  REPLAY_MOUSEX = 1 << 1,
+  REPLAY_MOUSEY = 1 << 2,
+  REPLAY_MOUSEDOWN = 1 << 3,
+  REPLAY_MOUSEHELD = 1 << 4,
+  REPLAY_MOUSEUP = 1 << 5,
+  REPLAY_MOUSERELEASED = 1 << 6,
+  REPLAY_REPEAT = 1 << 7,
+  REPLAY_SCENE_SWITCH = REPLAY_REPEAT | 1
+};
+
+// BM: Replay - Frame
+//==============================================================================
+/** @brief the part of Play, that is recorded each cycle */
+struct ReplayFrame {
+  float deltaTime = 0;
+  Vector2 mouseLoc = {0, 0};
+  unsigned char mouseDown = 0;
+  unsigned char mouseHeld = 0;
+  unsigned char mouseUp = 0;
+  unsigned char mouseReleased = 0;
+
+  static unsigned int floatBits(float f) {
+    unsigned int u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+  }
+
+  static float bitsFloat(unsigned int u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+};
+
+// BM: Replay - Recorder - Class
+//==============================================================================
+/**
+ * @brief Records the input of each cycle into a file, that can be played back
+ * with the InputReplayer.
+ *
+ * Also seeds the random number generators (std::rand and RayLibs
+ * GetRandomValue) before the first Scene starts, so the Play can be repeated
+ * exactly. (Scenes must not seed them again, while recording)
+ */
+class InputRecorder : public InputStream {
+public:
+  /**
+   * @param path - file to write the recording to
+   * @param seed - seed for the random number generators (0 = pick one from
+   * the current time)
+   */
+  InputRecorder(const char *path, unsigned int seed = 0);
+  ~InputRecorder();
+
+  /** @return the seed, that the recording was started with */
+  unsigned int Seed();
+
+  /** @return number of recorded cycles */
+  unsigned long Frames();
+
+private:
+  std::string _path;
+  FILE *_file;
+  unsigned int _seed;
+  unsigned long _frames;
+  unsigned long _repeats;
+  ReplayFrame _last;
+  std::vector<unsigned char> _buffer;
+
+  void writeByte(unsigned char b);
+  void writeVarint(unsigned long v);
+  void writeRepeats();
+  void flush();
+
+  // Implement - InputStream
+  //----------------------------------------------------------------------------
+  void OnPlayStart(Play &) override;
+  bool OnInput(Play &) override;
+  bool OnSceneSwitch(Play &, bool preloaded) override;
+  void OnPlayEnd(Play &) override;
+};
+
+// BM: Replay - Replayer - Class
+//==============================================================================
+/**
+ * @brief Feeds a recording made by the InputRecorder back into the Play.
+ * Ends the Play, once the recording ran out.
+ *
+ * Combine it with Builder::PlayHeadless, to replay a session without a window
+ * as fast as the CPU allows.
+ */
+class InputReplayer : public InputStream {
+public:
+  /** @param path - the file to replay */
+  InputReplayer(const char *path);
+
+  /** @return true = the recording was loaded and can be played */
+  bool IsReady();
+
+  /** @return the seed, that the recording was started with */
+  unsigned int Seed();
+
+  /** @return number of cycles replayed so far */
+  unsigned long Frames();
+
+private:
+  std::vector<unsigned char> _data;
+  size_t _pos;
+  bool _ready;
+  unsigned int _seed;
+  unsigned long _frames;
+  unsigned long _repeats;
+  ReplayFrame _last;
+
+  bool readByte(unsigned char *b);
+  bool readVarint(unsigned int *v);
+
+  // Implement - InputStream
+  //----------------------------------------------------------------------------
+  void OnPlayStart(Play &) override;
+  bool OnInput(Play &) override;
+  bool OnSceneSwitch(Play &, bool preloaded) override;
+};
+
+// BM: Replay - Helpers
+//==============================================================================
+inline void replaySeed(unsigned int seed) {
+  std::srand(seed);
+  SetRandomSeed(seed);
+}
+
+// BM: Replay - Recorder - Implementation
+//==============================================================================
+inline InputRecorder::InputRecorder(const char *path, unsigned int seed)
+    : _path(path), _file(NULL), _seed(seed), _frames(0), _repeats(0),
+      _last(), _buffer() {}
+
+inline InputRecorder::~InputRecorder() {
+  if (_file != NULL) {
+    writeRepeats();
+    flush();
+    fclose(_file);
+  }
+}
+
+inline unsigned int InputRecorder::Seed() { return _seed; }
+inline unsigned long InputRecorder::Frames() { return _frames; }
+
+inline void InputRecorder::writeByte(unsigned char b) {
+  _buffer.push_back(b);
+  if (_buffer.size() >= 4096)
+    flush();
+}
+
+inline void InputRecorder::writeVarint(unsigned long v) {
+  while (v >= 0x80) {
+    writeByte((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  writeByte(v);
+}
+
+inline void InputRecorder::writeRepeats() {
+  if (_repeats == 1)
+    writeByte(0);
+  else if (_repeats > 1) {
+    writeByte(REPLAY_REPEAT);
+    writeVarint(_repeats);
+  }
+  _repeats = 0;
+}
+
+inline void InputRecorder::flush() {
+  if (_file != NULL && _buffer.size() > 0)
+    fwrite(_buffer.data(), 1, _buffer.size(), _file);
+  _buffer.clear();
+}
+
+inline void InputRecorder::OnPlayStart(Play &p) {
+  if (_seed == 0)
+    _seed = (unsigned int)time(NULL);
+
+  replaySeed(_seed);
+
+  _file = fopen(_path.c_str(), "wb");
+  if (_file == NULL) {
+    std::cerr << "InputRecorder: can't open '" << _path << "' for writing"
+              << std::endl;
+    return;
+  }
+
+  const unsigned char header[] = {'R',
+                                  'T',
+                                  'I',
+                                  'R',
+                                  RAYTHEATER_REPLAY_VERSION,
+                                  (unsigned char)(_seed & 0xFF),
+                                  (unsigned char)((_seed >> 8) & 0xFF),
+                                  (unsigned char)((_seed >> 16) & 0xFF),
+                                  (unsigned char)((_seed >> 24) & 0xFF)};
+  fwrite(header, 1, sizeof(header), _file);
+}
+
+inline bool InputRecorder::OnInput(Play &p) {
+  if (_file == NULL)
+    return true;
+
+  unsigned int dt = ReplayFrame::floatBits(p.deltaTime) ^
+                    ReplayFrame::floatBits(_last.deltaTime);
+  unsigned int mx = ReplayFrame::floatBits(p.mouseLoc.x) ^
+                    ReplayFrame::floatBits(_last.mouseLoc.x);
+  unsigned int my = ReplayFrame::floatBits(p.mouseLoc.y) ^
+                    ReplayFrame::floatBits(_last.mouseLoc.y);
+
+  unsigned char flags =
+      (dt != 0 ? REPLAY_DELTATIME : 0) | (mx != 0 ? REPLAY_MOUSEX : 0) |
+      (my != 0 ? REPLAY_MOUSEY : 0) |
+      (p.mouseDown != _last.mouseDown ? REPLAY_MOUSEDOWN : 0) |
+      (p.mouseHeld != _last.mouseHeld ? REPLAY_MOUSEHELD : 0) |
+      (p.mouseUp != _last.mouseUp ? REPLAY_MOUSEUP : 0) |
+      (p.mouseReleased != _last.mouseReleased ? REPLAY_MOUSERELEASED : 0);
+
+  _frames++;
+
+  if (flags == 0) {
+    // The replayer reads runs as unsigned int; very long ones are split
+    if (_repeats == UINT_MAX)
+      writeRepeats();
+    _repeats++;
+    return true;
+  }
+
+  writeRepeats();
+  writeByte(flags);
+
+  if (flags & REPLAY_DELTATIME)
+    writeVarint(dt);
+  if (flags & REPLAY_MOUSEX)
+    writeVarint(mx);
+  if (flags & REPLAY_MOUSEY)
+    writeVarint(my);
+  if (flags & REPLAY_MOUSEDOWN)
+    writeByte(p.mouseDown);
+  if (flags & REPLAY_MOUSEHELD)
+    writeByte(p.mouseHeld);
+  if (flags & REPLAY_MOUSEUP)
+    writeByte(p.mouseUp);
+  if (flags & REPLAY_MOUSERELEASED)
+    writeByte(p.mouseReleased);
+
+  _last.deltaTime = p.deltaTime;
+  _last.mouseLoc = p.mouseLoc;
+  _last.mouseDown = p.mouseDown;
+  _last.mouseHeld = p.mouseHeld;
+  _last.mouseUp = p.mouseUp;
+  _last.mouseReleased = p.mouseReleased;
+
+  return true;
+}
+
+inline bool InputRecorder::OnSceneSwitch(Play &p, bool preloaded) {
+  if (_file != NULL && preloaded) {
+    writeRepeats();
+    writeByte(REPLAY_SCENE_SWITCH);
+  }
+  return preloaded;
+}
+
+inline void InputRecorder::OnPlayEnd(Play &p) {
+  if (_file == NULL)
+    return;
+
+  writeRepeats();
+  flush();
+  fclose(_file);
+  _file = NULL;
+}
+
+// BM: Replay - Replayer - Implementation
+//==============================================================================
+inline InputReplayer::InputReplayer(const char *path)
+    : _data(), _pos(0), _ready(false), _seed(0), _frames(0), _repeats(0),
+      _last() {
+
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    std::cerr << "InputReplayer: can't open '" << path << "'" << std::endl;
+    return;
+  }
+
+  unsigned char chunk[4096];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    _data.insert(_data.end(), chunk, chunk + read);
+  fclose(f);
+
+  if (_data.size() < 9 || _data[0] != 'R' || _data[1] != 'T' ||
+      _data[2] != 'I' || _data[3] != 'R' ||
+      _data[4] != RAYTHEATER_REPLAY_VERSION) {
+    std::cerr << "InputReplayer: '" << path << "' is not a supported recording"
+              << std::endl;
+    return;
+  }
+
+  _seed = _data[5] | (_data[6] << 8) | (_data[7] << 16) |
+          ((unsigned int)_data[8] << 24);
+  _pos = 9;
+  _ready = true;
+}
+
+inline bool InputReplayer::IsReady() { return _ready; }
+inline unsigned int InputReplayer::Seed() { return _seed; }
+inline unsigned long InputReplayer::Frames() { return _frames; }
+
+inline bool InputReplayer::readByte(unsigned char *b) {
+  if (_pos >= _data.size())
+    return false;
+
+  *b = _data[_pos++];
+  return true;
+}
+
+inline bool InputReplayer::readVarint(unsigned int *v) {
+  unsigned char b;
+  unsigned int shift = 0;
+  *v = 0;
+
+  do {
+    if (!readByte(&b) || shift > 28)
+      return false;
+
+    *v |= (unsigned int)(b & 0x7F) << shift;
+    shift += 7;
+  } while (b & 0x80);
+
+  return true;
+}
+
+inline void InputReplayer::OnPlayStart(Play &p) {
+  if (_ready)
+    replaySeed(_seed);
+}
+
+// Switches exactly, where the recording did; however long the preload takes
+inline bool InputReplayer::OnSceneSwitch(Play &p, bool preloaded) {
+  if (!_ready || _repeats > 0 || _pos >= _data.size() ||
+      _data[_pos] != REPLAY_SCENE_SWITCH)
+    return false;
+
+  _pos++;
+  return true;
+}
+
+inline bool InputReplayer::OnInput(Play &p) {
+  if (!_ready)
+    return false;
+
+  if (_repeats > 0) {
+    _repeats--;
+  } else {
+    unsigned char flags;
+    unsigned int bits;
+
+    // A switch, this Play did not reach (it played out differently)
+    do {
+      if (!readByte(&flags))
+        return false;
+    } while (flags == REPLAY_SCENE_SWITCH);
+
+    if (flags == REPLAY_REPEAT) {
+      if (!readVarint(&bits) || bits == 0)
+        return false;
+      _repeats = bits - 1;
+    } else {
+      if (flags & REPLAY_DELTATIME) {
+        if (!readVarint(&bits))
+          return false;
+        _last.deltaTime = ReplayFrame::bitsFloat(
+            bits ^ ReplayFrame::floatBits(_last.deltaTime));
+      }
+      if (flags & REPLAY_MOUSEX) {
+        if (!readVarint(&bits))
+          return false;
+        _last.mouseLoc.x = ReplayFrame::bitsFloat(
+            bits ^ ReplayFrame::floatBits(_last.mouseLoc.x));
+      }
+      if (flags & REPLAY_MOUSEY) {
+        if (!readVarint(&bits))
+          return false;
+        _last.mouseLoc.y = ReplayFrame::bitsFloat(
+            bits ^ ReplayFrame::floatBits(_last.mouseLoc.y));
+      }
+      if ((flags & REPLAY_MOUSEDOWN) && !readByte(&_last.mouseDown))
+        return false;
+      if ((flags & REPLAY_MOUSEHELD) && !readByte(&_last.mouseHeld))
+        return false;
+      if ((flags & REPLAY_MOUSEUP) && !readByte(&_last.mouseUp))
+        return false;
+      if ((flags & REPLAY_MOUSERELEASED) && !readByte(&_last.mouseReleased))
+        return false;
+    }
+  }
+
+  p.deltaTime = _last.deltaTime;
+  p.mouseLoc = _last.mouseLoc;
+  p.mouseX = std::floor(_last.mouseLoc.x);
+  p.mouseY = std::floor(_last.mouseLoc.y);
+  p.mouseDown = _last.mouseDown;
+  p.mouseHeld = _last.mouseHeld;
+  p.mouseUp = _last.mouseUp;
+  p.mouseReleased = _last.mouseReleased;
+
+  _frames++;
+  return true;
+}
+
+}; // namespace Theater
+
+#endif // RayTheaterReplay_H
@@ -0,0 +1,446 @@
+#ifndef RayTheaterSprites_H
+#define RayTheaterSprites_H 1
+
+#include <algorithm>
+#include <cmath>
+#include <raylib.h>
+#include <rlgl.h>
+#include <vector>
+
+#include "RayTheater.hpp"
+
+namespace Theater {
+
+class AnimatedSprite;
+class SpriteBatch;
+
+// BM: SpriteAtlas - Class
+//==============================================================================
+/** @brief A texture, packed with the frames of many animations, and the
+ * clips (sequences of frames) played from it. Shared by all sprites using it.
+ */
+class SpriteAtlas {
+public:
+  struct Clip {
+    unsigned int first; // into the clip frame list
+    unsigned int count;
+    float fps;
+    bool loop;
+  };
+
+  SpriteAtlas();
+  SpriteAtlas(Texture2D texture);
+
+  /** @brief the packed texture (may be set later, e.g. once loaded via the
+   * Stages ResourceCache) */
+  Texture2D texture;
+
+  /** @brief adds the area of one frame (in pixels)
+   * @return id of the frame */
+  unsigned int AddFrame(Rectangle source);
+
+  /** @brief adds cols x rows frames of the given size, row by row
+   * @return id of the first frame */
+  unsigned int AddGrid(Rectangle area, int cols, int rows);
+
+  /** @brief adds a clip, playing the given frames in order
+   * @return id of the clip */
+  unsigned int AddClip(const std::vector<unsigned int> &frames, float fps,
+                       bool loop = true);
+
+  /** @brief adds a clip, playing count frames from first on */
+  unsigned int AddClip(unsigned int first, unsigned int count, float fps,
+                       bool loop = true);
+
+  unsigned int FrameCount();
+  unsigned int ClipCount();
+
+private:
+  friend AnimatedSprite;
+  friend SpriteBatch;
+  std::vector<Rectangle> _frames;
+  std::vector<Clip> _clips;
+  std::vector<unsigned int> _clipFrames;
+};
+
+// BM: AnimatedSprite - Class
+//==============================================================================
+/** @brief Gives an Actor an animation from a SpriteAtlas. The sprite holds no
+ * animation state itself, its SpriteBatch advances and draws all of its
+ * sprites together.
+ *
+ * The sprite is drawn at the world location of the given Transform2D.
+ */
+class AnimatedSprite {
+public:
+  AnimatedSprite(Transform2D *transform);
+  AnimatedSprite(const AnimatedSprite &) = delete;
+  AnimatedSprite &operator=(const AnimatedSprite &) = delete;
+  ~AnimatedSprite();
+
+  /** @brief starts the clip of the batches atlas from its first frame
+   * @param speed - 1 = the clips fps, 2 = twice as fast, ...
+   * (Clips only play forward, a negative speed or fps holds the first frame)
+   */
+  void PlayClip(unsigned int clip, float speed = 1);
+
+  /** @brief freezes the animation on its current frame */
+  void Pause(bool paused = true);
+
+  /** @return false = the clip ended (or no clip) */
+  bool IsPlaying();
+
+  /** @return id of the atlas frame shown */
+  unsigned int GetFrame();
+
+  /** @brief color, the frame is multiplied with */
+  void SetTint(Color tint);
+
+  /** @brief mirrors the frame horizontally */
+  void SetFlipX(bool flip);
+
+  /** @brief point of the frame (0..1), that is placed on the location */
+  void SetPivot(Vector2 pivot);
+
+  /** @return the batch, the sprite is in (NULL = none) */
+  SpriteBatch *GetBatch();
+
+private:
+  friend SpriteBatch;
+  Transform2D *_transform;
+  SpriteBatch *_batch;
+  unsigned int _slot;
+};
+
+// BM: SpriteBatch - Class
+//==============================================================================
+/** @brief Advances and draws all AnimatedSprites of one SpriteAtlas. Their
+ * animation state is stored in one array per value and advanced in one loop
+ * per frame; the sprites are drawn as one batch of quads, with a single
+ * texture bind.
+ *
+ * Add the batch to the Stage like any other Actor. All its sprites are drawn
+ * on the batches render layer, in the order they were added.
+ */
+class SpriteBatch : public Actor, public Visible, public Ticking {
+public:
+  SpriteBatch(SpriteAtlas *atlas);
+  SpriteBatch(const SpriteBatch &) = delete;
+  SpriteBatch &operator=(const SpriteBatch &) = delete;
+  ~SpriteBatch();
+
+  /** @brief adds the sprite to the batch (and removes it from its old one)
+   * @return false = the sprite is already in this batch */
+  bool Add(AnimatedSprite *sprite);
+
+  /** @brief removes the sprite from the batch */
+  void Remove(AnimatedSprite *sprite);
+
+  /** @return number of sprites in the batch */
+  unsigned int Count();
+
+  SpriteAtlas *GetAtlas();
+
+private:
+  friend AnimatedSprite;
+  SpriteAtlas *_atlas;
+
+  // The sprites, one array per value
+  std::vector<AnimatedSprite *> _sprites;
+  std::vector<float> _time;  // frames played of the clip
+  std::vector<float> _rate;  // frames per second (0 = paused)
+  std::vector<float> _speed; // rate, once unpaused
+  std::vector<unsigned int> _clip;
+  std::vector<unsigned int> _frame; // atlas frame shown
+  std::vector<unsigned char> _playing;
+  std::vector<Color> _tint;
+  std::vector<unsigned char> _flipX;
+  std::vector<Vector2> _pivot;
+
+  void advance(float dt);
+
+  // Interfaces
+  //----------------------------------------------------------------------------
+public:
+  // Implement - Visible
+  //----------------------------------------------------------------------------
+  void OnDraw(Play) override;
+
+  // Implement - Ticking
+  //----------------------------------------------------------------------------
+  void OnTick(Play) override;
+};
+
+// BM: SpriteAtlas - Implementation
+//==============================================================================
+inline SpriteAtlas::SpriteAtlas()
+    : texture(), _frames(), _clips(), _clipFrames() {}
+
+inline SpriteAtlas::SpriteAtlas(Texture2D texture)
+    : texture(texture), _frames(), _clips(), _clipFrames() {}
+
+inline unsigned int SpriteAtlas::AddFrame(Rectangle source) {
+  _frames.push_back(source);
+  return _frames.size() - 1;
+}
+
+inline unsigned int SpriteAtlas::AddGrid(Rectangle area, int cols, int rows) {
+  unsigned int first = _frames.size();
+  float w = area.width / cols;
+  float h = area.height / rows;
+
+  for (int y = 0; y < rows; y++)
+    for (int x = 0; x < cols; x++)
+      _frames.push_back({area.x + x * w, area.y + y * h, w, h});
+
+  return first;
+}
+
+inline unsigned int
+SpriteAtlas::AddClip(const std::vector<unsigned int> &frames, float fps,
+                     bool loop) {
+  Clip c = {(unsigned int)_clipFrames.size(), (unsigned int)frames.size(), fps,
+            loop};
+  _clipFrames.insert(_clipFrames.end(), frames.begin(), frames.end());
+  _clips.push_back(c);
+  return _clips.size() - 1;
+}
+
+inline unsigned int SpriteAtlas::AddClip(unsigned int first,
+                                         unsigned int count, float fps,
+                                         bool loop) {
+  std::vector<unsigned int> frames(count);
+  for (unsigned int a = 0; a < count; a++)
+    frames[a] = first + a;
+  return AddClip(frames, fps, loop);
+}
+
+inline unsigned int SpriteAtlas::FrameCount() { return _frames.size(); }
+
+inline unsigned int SpriteAtlas::ClipCount() { return _clips.size(); }
+
+// BM: AnimatedSprite - Implementation
+//==============================================================================
+inline AnimatedSprite::AnimatedSprite(Transform2D *transform)
+    : _transform(transform), _batch(NULL), _slot(0) {}
+
+inline AnimatedSprite::~AnimatedSprite() {
+  if (_batch != NULL)
+    _batch->Remove(this);
+}
+
+inline void AnimatedSprite::PlayClip(unsigned int clip, float speed) {
+  if (_batch == NULL || clip >= _batch->_atlas->_clips.size())
+    return;
+
+  const SpriteAtlas::Clip &c = _batch->_atlas->_clips[clip];
+  _batch->_clip[_slot] = clip;
+  _batch->_time[_slot] = 0;
+  // A negative rate would run the time below 0, out of the clips frames
+  float rate = std::max(0.0f, c.fps * speed);
+  _batch->_speed[_slot] = rate;
+  _batch->_rate[_slot] = rate;
+  _batch->_playing[_slot] = 1;
+  _batch->_frame[_slot] =
+      c.count > 0 ? _batch->_atlas->_clipFrames[c.first] : 0;
+}
+
+inline void AnimatedSprite::Pause(bool paused) {
+  if (_batch != NULL)
+    _batch->_rate[_slot] = paused ? 0 : _batch->_speed[_slot];
+}
+
+inline bool AnimatedSprite::IsPlaying() {
+  return _batch != NULL && _batch->_playing[_slot] != 0;
+}
+
+inline unsigned int AnimatedSprite::GetFrame() {
+  return _batch != NULL ? _batch->_frame[_slot] : 0;
+}
+
+inline void AnimatedSprite::SetTint(Color tint) {
+  if (_batch != NULL)
+    _batch->_tint[_slot] = tint;
+}
+
+inline void AnimatedSprite::SetFlipX(bool flip) {
+  if (_batch != NULL)
+    _batch->_flipX[_slot] = flip ? 1 : 0;
+}
+
+inline void AnimatedSprite::SetPivot(Vector2 pivot) {
+  if (_batch != NULL)
+    _batch->_pivot[_slot] = pivot;
+}
+
+inline SpriteBatch *AnimatedSprite::GetBatch() { return _batch; }
+
+// BM: SpriteBatch - Implementation
+//==============================================================================
+inline SpriteBatch::SpriteBatch(SpriteAtlas *atlas)
+    : Actor(), Visible(this), Ticking(this), _atlas(atlas) {}
+
+inline SpriteBatch::~SpriteBatch() {
+  for (AnimatedSprite *s : _sprites)
+    s->_batch = NULL;
+}
+
+inline bool SpriteBatch::Add(AnimatedSprite *sprite) {
+  if (sprite->_batch == this)
+    return false;
+  if (sprite->_batch != NULL)
+    sprite->_batch->Remove(sprite);
+
+  sprite->_batch = this;
+  sprite->_slot = _sprites.size();
+
+  _sprites.push_back(sprite);
+  _time.push_back(0);
+  _rate.push_back(0);
+  _speed.push_back(0);
+  _clip.push_back(0);
+  _frame.push_back(0);
+  _playing.push_back(0);
+  _tint.push_back(WHITE);
+  _flipX.push_back(0);
+  _pivot.push_back({0.5f, 0.5f});
+  return true;
+}
+
+// Moves the last sprite into the slot of the removed one
+inline void SpriteBatch::Remove(AnimatedSprite *sprite) {
+  if (sprite->_batch != this)
+    return;
+
+  unsigned int slot = sprite->_slot;
+  sprite->_batch = NULL;
+
+  _sprites[slot] = _sprites.back();
+  _sprites[slot]->_slot = slot;
+  _time[slot] = _time.back();
+  _rate[slot] = _rate.back();
+  _speed[slot] = _speed.back();
+  _clip[slot] = _clip.back();
+  _frame[slot] = _frame.back();
+  _playing[slot] = _playing.back();
+  _tint[slot] = _tint.back();
+  _flipX[slot] = _flipX.back();
+  _pivot[slot] = _pivot.back();
+
+  _sprites.pop_back();
+  _time.pop_back();
+  _rate.pop_back();
+  _speed.pop_back();
+  _clip.pop_back();
+  _frame.pop_back();
+  _playing.pop_back();
+  _tint.pop_back();
+  _flipX.pop_back();
+  _pivot.pop_back();
+}
+
+inline unsigned int SpriteBatch::Count() { return _sprites.size(); }
+
+inline SpriteAtlas *SpriteBatch::GetAtlas() { return _atlas; }
+
+inline void SpriteBatch::advance(float dt) {
+  size_t cnt = _sprites.size();
+
+  // Plain loop over the times, so the compiler can vectorize it
+  float *__restrict time = _time.data();
+  const float *__restrict rate = _rate.data();
+  for (size_t i = 0; i < cnt; i++)
+    time[i] += rate[i] * dt;
+
+  // Look up the frame, each sprite shows now
+  const std::vector<SpriteAtlas::Clip> &clips = _atlas->_clips;
+  const unsigned int *clipFrames = _atlas->_clipFrames.data();
+  for (size_t i = 0; i < cnt; i++) {
+    if (_playing[i] == 0 || _clip[i] >= clips.size())
+      continue;
+
+    const SpriteAtlas::Clip &c = clips[_clip[i]];
+    if (c.count == 0)
+      continue;
+
+    if (time[i] >= c.count) {
+      if (c.loop) {
+        time[i] = std::fmod(time[i], (float)c.count);
+      } else {
+        time[i] = c.count - 1;
+        _playing[i] = 0;
+      }
+    }
+    _frame[i] = clipFrames[c.first + (unsigned int)time[i]];
+  }
+}
+
+inline void SpriteBatch::OnTick(Play p) { advance(p.deltaTime); }
+
+inline void SpriteBatch::OnDraw(Play p) {
+  const Texture2D &tex = _atlas->texture;
+  const std::vector<Rectangle> &frames = _atlas->_frames;
+  if (_sprites.empty() || tex.id == 0 || frames.empty())
+    return;
+
+  float texW = tex.width;
+  float texH = tex.height;
+
+  // Quads are sent in chunks, that fit into RayLibs render batch
+  const unsigned int chunk = 1024;
+  unsigned int cnt = _sprites.size();
+  for (unsigned int first = 0; first < cnt; first += chunk) {
+    unsigned int last = std::min(cnt, first + chunk);
+    rlCheckRenderBatchLimit((last - first) * 4);
+
+    rlSetTexture(tex.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+
+    for (unsigned int i = first; i < last; i++) {
+      Transform2D *t = _sprites[i]->_transform;
+      const Rectangle &src =
+          frames[_frame[i] < frames.size() ? _frame[i] : 0];
+
+      Vector2 loc = t->getWorldLoc();
+      float scale = t->getWorldScale();
+      float w = src.width * scale;
+      float h = src.height * scale;
+
+      // Corners relative to the location, before rotating
+      float x0 = -_pivot[i].x * w, x1 = x0 + w;
+      float y0 = -_pivot[i].y * h, y1 = y0 + h;
+
+      float u0 = src.x / texW, u1 = (src.x + src.width) / texW;
+      float v0 = src.y / texH, v1 = (src.y + src.height) / texH;
+      if (_flipX[i])
+        std::swap(u0, u1);
+
+      float c = 1, s = 0;
+      float rotation = t->getWorldRotation();
+      if (rotation != 0) {
+        c = std::cos(rotation * DEG2RAD);
+        s = std::sin(rotation * DEG2RAD);
+      }
+
+      const Color &tint = _tint[i];
+      rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+
+      rlTexCoord2f(u0, v0);
+      rlVertex2f(loc.x + x0 * c - y0 * s, loc.y + x0 * s + y0 * c);
+      rlTexCoord2f(u0, v1);
+      rlVertex2f(loc.x + x0 * c - y1 * s, loc.y + x0 * s + y1 * c);
+      rlTexCoord2f(u1, v1);
+      rlVertex2f(loc.x + x1 * c - y1 * s, loc.y + x1 * s + y1 * c);
+      rlTexCoord2f(u1, v0);
+      rlVertex2f(loc.x + x1 * c - y0 * s, loc.y + x1 * s + y0 * c);
+    }
+
+    rlEnd();
+    rlSetTexture(0);
+  }
+}
+
+} // namespace Theater
+
+#endif // RayTheaterSprites_H
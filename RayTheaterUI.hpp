@@ -2,28 +2,92 @@
 #define RayTheaterUI_H 1
 
 #include "raylib.h"
+#include "rlgl.h"
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "RayTheater.hpp"
+#include "RayTheaterCollider.hpp"
 
 namespace Theater {
 namespace UI {
 
+// Radius (in pixels) of the rounded corners in the Buttons background skins.
+// Corners are scaled from there to their size on the Button
+#ifndef UI_SKIN_RADIUS
+#define UI_SKIN_RADIUS 32
+#endif
+
+class InputRouter;
+class Container;
+
+// BM: LayoutNode - Class
+//==============================================================================
+enum Alignment { ALIGN_START, ALIGN_CENTER, ALIGN_END };
+
+/** @brief Something, a Container can lay out. Layout runs in two passes:
+ * Measure asks each node for the size it wants, Arrange hands it the area it
+ * gets. Both results are cached, until the node (or something inside it)
+ * calls InvalidateLayout.
+ */
+class LayoutNode {
+  friend class Container;
+
+public:
+  virtual ~LayoutNode() {}
+
+  /** @return the size, the node wants (cached) */
+  Vector2 Measure();
+
+  /** @brief places the node in slot; does nothing, if it is already laid out
+   * there */
+  void Arrange(Rectangle slot);
+
+  /** @brief marks this node and all Containers above it, to be laid out anew
+   * with the next frame */
+  void InvalidateLayout();
+
+  /** @return the area, the node was last arranged in */
+  Rectangle GetLayoutRect();
+
+  Container *GetParent();
+
+protected:
+  /** @return the size, the node wants */
+  virtual Vector2 measure() = 0;
+
+  /** @brief places the node (and its children) inside slot */
+  virtual void arrange(Rectangle slot) = 0;
+
+private:
+  Container *_parent = NULL;
+  bool _measured = false;
+  bool _arranged = false;
+  Vector2 _desired = {0, 0};
+  Rectangle _slot = {0, 0, 0, 0};
+};
+
 // BM: Label - Class
 //==============================================================================
-class Label : public Actor, public Visible {
+class Label : public Actor, public Visible, public LayoutNode {
 public:
   struct UIStyle {
     Color textColor = WHITE;
     float fontSize = 10;
-    Font font = GetFontDefault();
+    // An empty Font (texture.id == 0) draws with RayLibs default Font
+    Font font = {};
   };
 
   Label();
   Label(std::string);
 
-  Label *Text(std::string);
+  /** @brief changes the text. Unchanged texts are not copied, changed ones
+   * reuse the memory of the old text where possible */
+  Label *Text(const std::string &);
+  Label *Text(const char *);
   Label *Style(UIStyle *);
   Label *Position(float x, float y);
 
@@ -32,6 +96,12 @@ private:
   UIStyle *_style;
   std::string _text;
 
+protected:
+  // Implement - LayoutNode
+  //----------------------------------------------------------------------------
+  Vector2 measure() override;
+  void arrange(Rectangle slot) override;
+
 public:
   // Implement - Visible
   //------------------------------------------------------------------------------
@@ -40,10 +110,18 @@ public:
 
 // BM: Button - Class
 //==============================================================================
+/** @brief A clickable Element. Buttons don't tick: the InputRouter of the
+ * Scene tests them against the mouse and passes events to the topmost one.
+ *
+ * The background is a nine-slice skin, shared by all Buttons with the same
+ * rounded corners, and drawn as nine quads at any size, so restyling or
+ * resizing a Button redraws nothing up front.
+ */
 class Button : public Actor,
                public ColliderRect,
                public Visible,
-               public Ticking {
+               public LayoutNode {
+  friend class InputRouter;
 
 public:
   enum ButtonEvent { BTN_HOVER, BTN_PRESS, BTN_HOLD, BTN_RELEASE, BTN_OUT };
@@ -52,7 +130,8 @@ public:
 
   struct UIStyle {
     Color textColor = WHITE;
-    Font font = GetFontDefault();
+    // An empty Font (texture.id == 0) draws with RayLibs default Font
+    Font font = {};
     float fontSize = 10;
 
     Color backgroundColor = GRAY;
@@ -66,9 +145,11 @@ public:
   };
 
   Button(int id, float x, float y, float w, float h);
-  ~Button();
 
-  Button *Label(std::string str);
+  Button *Label(const std::string &str);
+  Button *Label(const char *str);
+
+  Button *Size(float w, float h);
 
   Button *Style(UIStyle *);
 
@@ -82,7 +163,6 @@ public:
 
 private:
   UIStyle *_style;
-  bool _onStage = false;
 
   enum ButtonState { STATE_IDLE, STATE_ACTIVATE, STATE_HELD };
   ButtonState _state;
@@ -90,10 +170,6 @@ private:
   int _id;
   Rectangle _drawRect;
   std::string _label;
-  Vector2 _labelPosition;
-
-  Rectangle _srcRect;
-  Vector2 _textOrigin;
 
   ButtonEventHandler *_hoverhandler = NULL;
   ButtonEventHandler *_presshandler = NULL;
@@ -101,14 +177,27 @@ private:
   ButtonEventHandler *_releasehandler = NULL;
   ButtonEventHandler *_outhandler = NULL;
 
-  RenderTexture2D _texture;
+  // Order, in which the InputRouter got the Button (later = drawn on top)
+  unsigned int _routeOrder = 0;
+  InputRouter *_router = NULL;
 
   // Helpers
   //----------------------------------------------------------------------------
-  void rerender();
+  /** @return the white background skin for the styles rounded corners */
+  static Texture2D skin(const UIStyle *s);
+
+  /** @brief advances the Buttons state and calls its handlers
+   * @param inside - if the mouse is over this Button (and no other above) */
+  void route(Play p, bool inside);
 
   // Interfaces
   //----------------------------------------------------------------------------
+protected:
+  // Implement - LayoutNode
+  //----------------------------------------------------------------------------
+  Vector2 measure() override;
+  void arrange(Rectangle slot) override;
+
 public:
   // Implement - ColliderRect
   //----------------------------------------------------------------------------
@@ -118,7 +207,72 @@ public:
   //----------------------------------------------------------------------------
   void OnDraw(Play) override;
 
-  // Implement - Tickable
+  // Implement - Actor
+  //----------------------------------------------------------------------------
+  void OnStageEnter(Play) override;
+  void OnStageLeave(Play) override;
+};
+
+// BM: InputRouter - Class
+//==============================================================================
+/** @brief Routes the mouse to the Buttons of a Scene. Each Scene gets one
+ * (see Stage::SceneState), which puts itself on the Stage with the first
+ * Button.
+ *
+ * The Buttons are kept in a ColliderGrid. Once per frame, and only if the
+ * mouse moved, a mouse button changed or Buttons came or went, the router
+ * looks up the topmost Button under the mouse (highest render layer, then
+ * the one made visible last). Events go to that Button, and to the one, the
+ * mouse just left, only.
+ */
+class InputRouter : public Actor, public Ticking {
+  friend class Button;
+
+public:
+  InputRouter();
+
+  /** @return the Button under the mouse (NULL = none) */
+  Button *Hovered();
+
+  /** @return number of Buttons, the router looks after */
+  unsigned int Count();
+
+  /** @brief sorts b into the grid again, after it moved, was resized or
+   * changed its render layer */
+  void Moved(Button *b);
+
+private:
+  // The mouse, as seen by the grid
+  class Probe : public ColliderPoint {
+  public:
+    Vector2 loc = {0, 0};
+    Vector2 getPosition() override { return loc; }
+  };
+
+  ColliderGrid _grid;
+  Probe _probe;
+  unsigned int _count;
+  unsigned int _sequence;
+  bool _onStage;
+  bool _dirty;
+
+  int _lastX;
+  int _lastY;
+  unsigned char _lastButtons;
+
+  Button *_hovered; // topmost Button under the mouse
+  Button *_active;  // Button, that is pressed or held
+
+  // Helpers
+  //----------------------------------------------------------------------------
+  void add(Play p, Button *b);
+  void remove(Button *b);
+  Button *hitTest(int x, int y);
+
+  // Interfaces
+  //----------------------------------------------------------------------------
+public:
+  // Implement - Ticking
   //----------------------------------------------------------------------------
   void OnTick(Play) override;
 
@@ -128,90 +282,240 @@ public:
   void OnStageLeave(Play) override;
 };
 
+// BM: Container - Class
+//==============================================================================
+/** @brief Lays out Labels, Buttons and other Containers. The Container, that
+ * is added to the Stage, is the root: it lays out its whole tree, whenever
+ * something in it was invalidated (text or style changed, children came or
+ * went, the window was resized). Only the invalidated parts are measured and
+ * arranged again.
+ *
+ * Containers don't own their children. Children still need to be added to
+ * the Stage (nested Containers don't).
+ */
+class Container : public Actor, public Ticking, public LayoutNode {
+public:
+  Container();
+
+  Container *Add(LayoutNode *child);
+  Container *Remove(LayoutNode *child);
+  Container *Clear();
+
+  /** @brief space (in pixels) between the border and the children */
+  Container *Padding(float p);
+
+  /** @brief space (in pixels) between the children */
+  Container *Spacing(float s);
+
+  /** @brief where the children go, if there is more space than they need */
+  Container *Align(Alignment horizontal, Alignment vertical);
+
+  /** @brief where the root is placed on the Stage */
+  Container *Position(float x, float y);
+
+  /** @brief fixed size (0 = as big as the children need) */
+  Container *Size(float w, float h);
+
+  /** @brief true = the root covers the whole Stage */
+  Container *FillStage(bool on);
+
+  unsigned int ChildCount();
+
+protected:
+  std::vector<LayoutNode *> _children;
+  float _padding;
+  float _spacing;
+  Alignment _alignH;
+  Alignment _alignV;
+
+  /** @return size, the children need (without the padding) */
+  virtual Vector2 measureContent() = 0;
+
+  /** @brief places the children inside content (padding already taken off)
+   */
+  virtual void arrangeContent(Rectangle content) = 0;
+
+  /** @return offset of something of size inside space, by alignment */
+  static float align(Alignment a, float space, float size);
+
+  /** @brief places child in the cell, aligned by the Containers alignment */
+  void placeIn(LayoutNode *child, Rectangle cell);
+
+private:
+  Vector2 _pos;
+  Vector2 _size;
+  bool _fillStage;
+  Vector2 _stageSize;
+  Vector2 _content; // size of the children, as of the last measure
+
+  // Implement - LayoutNode
+  //----------------------------------------------------------------------------
+  Vector2 measure() override;
+  void arrange(Rectangle slot) override;
+
+  // Interfaces
+  //----------------------------------------------------------------------------
+public:
+  // Implement - Ticking
+  //----------------------------------------------------------------------------
+  void OnTick(Play) override;
+
+  // Implement - Actor
+  //----------------------------------------------------------------------------
+  void OnStageResize(Play) override;
+};
+
+/** @brief children on top of each other */
+class Stack : public Container {
+protected:
+  Vector2 measureContent() override;
+  void arrangeContent(Rectangle content) override;
+};
+
+/** @brief children side by side, left to right */
+class Row : public Container {
+protected:
+  Vector2 measureContent() override;
+  void arrangeContent(Rectangle content) override;
+};
+
+/** @brief children below each other, top to bottom */
+class Column : public Container {
+protected:
+  Vector2 measureContent() override;
+  void arrangeContent(Rectangle content) override;
+};
+
+/** @brief children in cells of equal size, row by row */
+class Grid : public Container {
+public:
+  Grid(unsigned int columns);
+
+  Grid *Columns(unsigned int columns);
+
+protected:
+  unsigned int _columns;
+  Vector2 _cell;
+
+  Vector2 measureContent() override;
+  void arrangeContent(Rectangle content) override;
+};
+
 // BM: Button - Implementation
 //==============================================================================
 static Button::UIStyle defaultButtonStyle = {};
 
 inline Button::Button(int id, float x, float y, float w, float h)
-    : Actor(), Visible(this), Ticking(this), _drawRect({x, y, w, h}), _id(id),
+    : Actor(), Visible(this), _drawRect({x, y, w, h}), _id(id),
       _label(std::to_string(id)), _state(STATE_IDLE),
-      _style(&defaultButtonStyle), _srcRect({0, 0, w, -h}),
-      _textOrigin({0, 0}) {}
-
-inline Button::~Button() { UnloadRenderTexture(_texture); }
-
-inline void Button::rerender() {
-  if (!_onStage)
-    return;
-
-  this->_labelPosition.x = this->_drawRect.x + this->_style->labelOffset.x;
-  this->_labelPosition.y = this->_drawRect.y + this->_style->labelOffset.y;
-
-  BeginTextureMode(_texture);
-  ClearBackground(BLANK);
-
-  float rad = fmin(this->_drawRect.width, this->_drawRect.height) *
-              (this->_style->cornorRadius * 0.5);
-  float rad2 = rad * 2;
-
-  if ((_style->backgroundColor.a + _style->backgroundColor.r +
-       _style->backgroundColor.g + _style->backgroundColor.b) > 0) {
-
-    if (rad > 0) {
-      if (_style->roundTL)
-        DrawCircle(rad, rad, rad, this->_style->backgroundColor);
-      else
-        DrawRectangle(0, 0, rad2, rad2, this->_style->backgroundColor);
-
-      if (_style->roundTR)
-        DrawCircle(this->_drawRect.width - rad, rad, rad,
-                   this->_style->backgroundColor);
-      else
-        DrawRectangle(0, this->_drawRect.width - rad2, rad2, rad2,
-                      this->_style->backgroundColor);
-
-      if (_style->roundBL)
-        DrawCircle(rad, this->_drawRect.height - rad, rad,
-                   this->_style->backgroundColor);
-      else
-        DrawRectangle(0, this->_drawRect.height - rad2, rad2, rad2,
-                      this->_style->backgroundColor);
-
-      if (_style->roundBR)
-        DrawCircle(this->_drawRect.width - rad, this->_drawRect.height - rad,
-                   rad, this->_style->backgroundColor);
-
-      else
-        DrawRectangle(this->_drawRect.width - rad2,
-                      this->_drawRect.height - rad2, rad2, rad2,
-                      this->_style->backgroundColor);
-
-      DrawRectangle(rad, 0, this->_drawRect.width - rad2,
-                    this->_drawRect.height, this->_style->backgroundColor);
+      _style(&defaultButtonStyle) {}
+
+// The shape is drawn in white, once per combination of rounded corners, and
+// tinted with the styles backgroundColor, when drawn. Corners are quarter
+// circles of UI_SKIN_RADIUS pixels around a single stretched center pixel
+inline Texture2D Button::skin(const UIStyle *s) {
+  static Texture2D skins[16] = {};
+
+  unsigned int corners = (s->roundTL ? 1 : 0) | (s->roundTR ? 2 : 0) |
+                         (s->roundBL ? 4 : 0) | (s->roundBR ? 8 : 0);
+  Texture2D &t = skins[corners];
+  if (t.id != 0)
+    return t;
+
+  const int r = UI_SKIN_RADIUS;
+  const int size = r * 2 + 1;
+  std::vector<Color> pixels(size * size, WHITE);
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      if (x == r || y == r)
+        continue;
+
+      bool left = x < r;
+      bool top = y < r;
+      unsigned int corner = top ? (left ? 1 : 2) : (left ? 4 : 8);
+      if ((corners & corner) == 0)
+        continue;
+
+      // Distance to the corners circle center, antialiased over one pixel
+      float dx = left ? r - (x + 0.5f) : (x + 0.5f) - (r + 1);
+      float dy = top ? r - (y + 0.5f) : (y + 0.5f) - (r + 1);
+      float coverage = r + 0.5f - std::sqrt(dx * dx + dy * dy);
+      coverage = std::max(0.0f, std::min(1.0f, coverage));
+      pixels[y * size + x].a = (unsigned char)(coverage * 255);
     }
-
-    DrawRectangle(0, rad, this->_drawRect.width, this->_drawRect.height - rad2,
-                  this->_style->backgroundColor);
   }
 
-  if ((_style->textColor.a + _style->textColor.r + _style->textColor.g +
-       _style->textColor.b) > 0 &&
-      this->_label.size() > 0)
-    DrawTextPro(_style->font, _label.c_str(), this->_style->labelOffset, {0, 0},
-                0, _style->fontSize, 1, _style->textColor);
-
-  EndTextureMode();
+  Image img = {pixels.data(), size, size, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+  t = LoadTextureFromImage(img);
+  SetTextureFilter(t, TEXTURE_FILTER_BILINEAR);
+  return t;
 }
 
 inline Rectangle Button::getRect() { return _drawRect; }
 
+inline Vector2 Button::measure() { return {_drawRect.width, _drawRect.height}; }
+
+// Buttons keep their size, they are only moved
+inline void Button::arrange(Rectangle slot) {
+  if (_drawRect.x == slot.x && _drawRect.y == slot.y)
+    return;
+
+  _drawRect.x = slot.x;
+  _drawRect.y = slot.y;
+  if (_router != NULL)
+    _router->Moved(this);
+}
+
 inline void Button::OnDraw(Play p) {
-  DrawTexturePro(_texture.texture, _srcRect, _drawRect, _textOrigin, 0, WHITE);
+  const Rectangle &d = _drawRect;
+  const Color &bg = _style->backgroundColor;
+
+  if (bg.a > 0) {
+    float rad = std::min(d.width, d.height) * (_style->cornorRadius * 0.5f);
+
+    // Borders of the nine slices, on the Stage and in the skin
+    float xs[4] = {d.x, d.x + rad, d.x + d.width - rad, d.x + d.width};
+    float ys[4] = {d.y, d.y + rad, d.y + d.height - rad, d.y + d.height};
+    const float r = UI_SKIN_RADIUS;
+    const float uv[4] = {0, r / (r * 2 + 1), (r + 1) / (r * 2 + 1), 1};
+
+    rlCheckRenderBatchLimit(36);
+    rlSetTexture(skin(_style).id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    rlColor4ub(bg.r, bg.g, bg.b, bg.a);
+
+    for (int row = 0; row < 3; row++) {
+      for (int col = 0; col < 3; col++) {
+        if (xs[col] == xs[col + 1] || ys[row] == ys[row + 1])
+          continue;
+
+        rlTexCoord2f(uv[col], uv[row]);
+        rlVertex2f(xs[col], ys[row]);
+        rlTexCoord2f(uv[col], uv[row + 1]);
+        rlVertex2f(xs[col], ys[row + 1]);
+        rlTexCoord2f(uv[col + 1], uv[row + 1]);
+        rlVertex2f(xs[col + 1], ys[row + 1]);
+        rlTexCoord2f(uv[col + 1], uv[row]);
+        rlVertex2f(xs[col + 1], ys[row]);
+      }
+    }
+
+    rlEnd();
+    rlSetTexture(0);
+  }
+
+  if (_style->textColor.a > 0 && _label.size() > 0)
+    DrawTextPro(_style->font.texture.id == 0 ? GetFontDefault() : _style->font,
+                _label.c_str(),
+                {d.x + _style->labelOffset.x, d.y + _style->labelOffset.y},
+                {0, 0}, 0, _style->fontSize, 1, _style->textColor);
 }
 
-inline void Button::OnTick(Play p) {
+inline void Button::route(Play p, bool inside) {
 
-  if (containsPoint(p.mouseX, p.mouseY)) {
+  if (inside) {
 
     switch (_state) {
     case STATE_IDLE:
@@ -257,15 +561,107 @@ inline void Button::OnTick(Play p) {
 }
 
 inline void Button::OnStageEnter(Play p) {
-  _texture = LoadRenderTexture(_drawRect.width, _drawRect.height);
-  _onStage = true;
-  rerender();
   p.stage->MakeActorVisible(this);
+  p.stage->SceneState<InputRouter>().add(p, this);
 }
 inline void Button::OnStageLeave(Play p) {
+  p.stage->SceneState<InputRouter>().remove(this);
   p.stage->MakeActorInvisible(this);
+  _state = STATE_IDLE;
+}
+
+//==============================================================================
+// BM: InputRouter - Implementation
+//==============================================================================
+inline InputRouter::InputRouter()
+    : Actor(), Ticking(this), _grid(), _probe(), _count(0), _sequence(0),
+      _onStage(false), _dirty(true), _lastX(INT_MIN), _lastY(INT_MIN),
+      _lastButtons(0), _hovered(NULL), _active(NULL) {}
+
+inline Button *InputRouter::Hovered() { return _hovered; }
+
+inline unsigned int InputRouter::Count() { return _count; }
+
+inline void InputRouter::Moved(Button *b) {
+  _grid.Moved(b);
+  _dirty = true;
+}
+
+inline void InputRouter::add(Play p, Button *b) {
+  if (!_onStage)
+    p.stage->AddActor(this);
+
+  b->_routeOrder = _sequence++;
+  b->_router = this;
+  _grid.Add(b);
+  _count++;
+  _dirty = true;
+}
+
+inline void InputRouter::remove(Button *b) {
+  b->_router = NULL;
+  _grid.Remove(b);
+  _count--;
+  _dirty = true;
+
+  if (_hovered == b)
+    _hovered = NULL;
+  if (_active == b)
+    _active = NULL;
+}
+
+inline Button *InputRouter::hitTest(int x, int y) {
+  Button *top = NULL;
+  _probe.loc = {(float)x, (float)y};
+
+  _grid.ForEachCollidingWith(&_probe, [&top](Collider *c) {
+    Button *b = static_cast<Button *>(static_cast<ColliderRect *>(c));
+    if (top == NULL || b->GetRenderLayer() > top->GetRenderLayer() ||
+        (b->GetRenderLayer() == top->GetRenderLayer() &&
+         b->_routeOrder > top->_routeOrder))
+      top = b;
+  });
+
+  return top;
+}
+
+inline void InputRouter::OnTick(Play p) {
+  unsigned char buttons = p.mouseDown | p.mouseHeld;
+
+  if (_dirty || p.mouseX != _lastX || p.mouseY != _lastY ||
+      buttons != _lastButtons) {
+    _hovered = hitTest(p.mouseX, p.mouseY);
+    _lastX = p.mouseX;
+    _lastY = p.mouseY;
+    _lastButtons = buttons;
+    _dirty = false;
+  }
+
+  // The mouse left the pressed Button
+  if (_active != NULL && _active != _hovered) {
+    Button *left = _active;
+    _active = NULL;
+    left->route(p, false);
+  }
+
+  if (_hovered == NULL)
+    return;
+
+  Button *b = _hovered;
+  b->route(p, true);
+
+  // The handlers may have removed the Button
+  if (_hovered == b)
+    _active = b->_state != Button::STATE_IDLE ? b : NULL;
+}
+
+inline void InputRouter::OnStageEnter(Play) { _onStage = true; }
+
+inline void InputRouter::OnStageLeave(Play) {
   _onStage = false;
-  UnloadRenderTexture(_texture);
+  _hovered = NULL;
+  _active = NULL;
+  _dirty = true;
 }
 
 //==============================================================================
@@ -301,15 +697,32 @@ inline Button *Button::OnEvent(ButtonEventHandler *h) {
   return this;
 }
 
-inline Button *Button::Label(std::string str) {
-  _label = str;
-  this->rerender();
+inline Button *Button::Label(const std::string &str) {
+  if (_label != str)
+    _label = str;
+  return this;
+}
+
+inline Button *Button::Label(const char *str) {
+  if (_label != str)
+    _label.assign(str);
   return this;
 }
 
 inline Button *Button::Style(Button::UIStyle *s) {
-  this->_style = s;
-  this->rerender();
+  this->_style = s != NULL ? s : &defaultButtonStyle;
+  return this;
+}
+
+inline Button *Button::Size(float w, float h) {
+  if (_drawRect.width == w && _drawRect.height == h)
+    return this;
+
+  _drawRect.width = w;
+  _drawRect.height = h;
+  InvalidateLayout();
+  if (_router != NULL)
+    _router->Moved(this);
   return this;
 }
 
@@ -323,8 +736,21 @@ inline Label::Label()
       _text(" - ") {}
 inline Label::Label(std::string txt) : Label() { _text = txt; };
 
-inline Label *Label::Text(std::string s) {
+inline Label *Label::Text(const std::string &s) {
+  if (s == _text)
+    return this;
+
   _text = s;
+  InvalidateLayout();
+  return this;
+}
+
+inline Label *Label::Text(const char *s) {
+  if (_text == s)
+    return this;
+
+  _text.assign(s);
+  InvalidateLayout();
   return this;
 }
 inline Label *Label::Position(float x, float y) {
@@ -338,13 +764,291 @@ inline Label *Label::Style(UIStyle *s) {
   else
     _style = s;
 
+  InvalidateLayout();
   return this;
 };
 
+inline Vector2 Label::measure() {
+  return MeasureTextEx(_style->font.texture.id == 0 ? GetFontDefault()
+                                                    : _style->font,
+                       _text.c_str(), _style->fontSize, 1);
+}
+
+inline void Label::arrange(Rectangle slot) { _pos = {slot.x, slot.y}; }
+
 inline void Label::OnDraw(Play p) {
-  DrawTextPro(_style->font, _text.c_str(), _pos, {0, 0}, 0, _style->fontSize, 1,
+  DrawTextPro(_style->font.texture.id == 0 ? GetFontDefault() : _style->font,
+              _text.c_str(), _pos, {0, 0}, 0, _style->fontSize, 1,
               _style->textColor);
 }
+//==============================================================================
+// BM: LayoutNode - Implementation
+//==============================================================================
+inline Vector2 LayoutNode::Measure() {
+  if (!_measured) {
+    _desired = measure();
+    _measured = true;
+  }
+  return _desired;
+}
+
+inline void LayoutNode::Arrange(Rectangle slot) {
+  if (_arranged && slot.x == _slot.x && slot.y == _slot.y &&
+      slot.width == _slot.width && slot.height == _slot.height)
+    return;
+
+  _slot = slot;
+  _arranged = true;
+  arrange(slot);
+}
+
+inline void LayoutNode::InvalidateLayout() {
+  // Once a node is invalid, so are all nodes above it
+  for (LayoutNode *n = this; n != NULL && (n->_measured || n->_arranged);
+       n = n->_parent) {
+    n->_measured = false;
+    n->_arranged = false;
+  }
+}
+
+inline Rectangle LayoutNode::GetLayoutRect() { return _slot; }
+
+inline Container *LayoutNode::GetParent() { return _parent; }
+
+//==============================================================================
+// BM: Container - Implementation
+//==============================================================================
+inline Container::Container()
+    : Actor(), Ticking(this), _children(), _padding(0), _spacing(0),
+      _alignH(ALIGN_START), _alignV(ALIGN_START), _pos({0, 0}),
+      _size({0, 0}), _fillStage(false), _stageSize({0, 0}),
+      _content({0, 0}) {}
+
+inline Container *Container::Add(LayoutNode *child) {
+  if (child == NULL || child->_parent == this)
+    return this;
+
+  if (child->_parent != NULL)
+    child->_parent->Remove(child);
+
+  child->_parent = this;
+  _children.push_back(child);
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Remove(LayoutNode *child) {
+  auto found = std::find(_children.begin(), _children.end(), child);
+  if (found == _children.end())
+    return this;
+
+  _children.erase(found);
+  child->_parent = NULL;
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Clear() {
+  for (LayoutNode *child : _children)
+    child->_parent = NULL;
+  _children.clear();
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Padding(float p) {
+  _padding = p;
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Spacing(float s) {
+  _spacing = s;
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Align(Alignment horizontal, Alignment vertical) {
+  _alignH = horizontal;
+  _alignV = vertical;
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Position(float x, float y) {
+  _pos = {x, y};
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::Size(float w, float h) {
+  _size = {w, h};
+  InvalidateLayout();
+  return this;
+}
+
+inline Container *Container::FillStage(bool on) {
+  _fillStage = on;
+  InvalidateLayout();
+  return this;
+}
+
+inline unsigned int Container::ChildCount() { return _children.size(); }
+
+inline float Container::align(Alignment a, float space, float size) {
+  switch (a) {
+  case ALIGN_CENTER:
+    return (space - size) * 0.5f;
+  case ALIGN_END:
+    return space - size;
+  default:
+    return 0;
+  }
+}
+
+inline void Container::placeIn(LayoutNode *child, Rectangle cell) {
+  Vector2 size = child->Measure();
+  child->Arrange({cell.x + align(_alignH, cell.width, size.x),
+                  cell.y + align(_alignV, cell.height, size.y), size.x,
+                  size.y});
+}
+
+inline Vector2 Container::measure() {
+  _content = measureContent();
+  return {_size.x > 0 ? _size.x : _content.x + _padding * 2,
+          _size.y > 0 ? _size.y : _content.y + _padding * 2};
+}
+
+// Arrange always follows a Measure, so _content is up to date
+inline void Container::arrange(Rectangle slot) {
+  // The content as a block, aligned inside the Container
+  Vector2 content = _content;
+  float w = slot.width - _padding * 2;
+  float h = slot.height - _padding * 2;
+
+  arrangeContent({slot.x + _padding + align(_alignH, w, content.x),
+                  slot.y + _padding + align(_alignV, h, content.y), content.x,
+                  content.y});
+}
+
+// Only the root lays out; Containers inside it are laid out by their parent
+inline void Container::OnTick(Play p) {
+  if (GetParent() != NULL)
+    return;
+
+  if (_fillStage && (_stageSize.x != p.stageWidth ||
+                     _stageSize.y != p.stageHeight)) {
+    _stageSize = {(float)p.stageWidth, (float)p.stageHeight};
+    InvalidateLayout();
+  }
+
+  Vector2 size = Measure();
+  if (_fillStage)
+    Arrange({0, 0, _stageSize.x, _stageSize.y});
+  else
+    Arrange({_pos.x, _pos.y, size.x, size.y});
+}
+
+inline void Container::OnStageResize(Play) {
+  if (_fillStage)
+    InvalidateLayout();
+}
+
+//==============================================================================
+// BM: Container - Implementation - Stack, Row, Column, Grid
+//------------------------------------------------------------------------------
+inline Vector2 Stack::measureContent() {
+  Vector2 size = {0, 0};
+  for (LayoutNode *child : _children) {
+    Vector2 c = child->Measure();
+    size.x = std::max(size.x, c.x);
+    size.y = std::max(size.y, c.y);
+  }
+  return size;
+}
+
+inline void Stack::arrangeContent(Rectangle content) {
+  for (LayoutNode *child : _children)
+    placeIn(child, content);
+}
+
+inline Vector2 Row::measureContent() {
+  Vector2 size = {0, 0};
+  for (LayoutNode *child : _children) {
+    Vector2 c = child->Measure();
+    size.x += c.x;
+    size.y = std::max(size.y, c.y);
+  }
+  if (!_children.empty())
+    size.x += _spacing * (_children.size() - 1);
+  return size;
+}
+
+inline void Row::arrangeContent(Rectangle content) {
+  float x = content.x;
+  for (LayoutNode *child : _children) {
+    float w = child->Measure().x;
+    placeIn(child, {x, content.y, w, content.height});
+    x += w + _spacing;
+  }
+}
+
+inline Vector2 Column::measureContent() {
+  Vector2 size = {0, 0};
+  for (LayoutNode *child : _children) {
+    Vector2 c = child->Measure();
+    size.x = std::max(size.x, c.x);
+    size.y += c.y;
+  }
+  if (!_children.empty())
+    size.y += _spacing * (_children.size() - 1);
+  return size;
+}
+
+inline void Column::arrangeContent(Rectangle content) {
+  float y = content.y;
+  for (LayoutNode *child : _children) {
+    float h = child->Measure().y;
+    placeIn(child, {content.x, y, content.width, h});
+    y += h + _spacing;
+  }
+}
+
+inline Grid::Grid(unsigned int columns)
+    : Container(), _columns(columns > 0 ? columns : 1), _cell({0, 0}) {}
+
+inline Grid *Grid::Columns(unsigned int columns) {
+  _columns = columns > 0 ? columns : 1;
+  InvalidateLayout();
+  return this;
+}
+
+inline Vector2 Grid::measureContent() {
+  _cell = {0, 0};
+  for (LayoutNode *child : _children) {
+    Vector2 c = child->Measure();
+    _cell.x = std::max(_cell.x, c.x);
+    _cell.y = std::max(_cell.y, c.y);
+  }
+
+  unsigned int count = _children.size();
+  if (count == 0)
+    return {0, 0};
+
+  unsigned int cols = std::min(_columns, count);
+  unsigned int rows = (count + _columns - 1) / _columns;
+  return {cols * _cell.x + (cols - 1) * _spacing,
+          rows * _cell.y + (rows - 1) * _spacing};
+}
+
+inline void Grid::arrangeContent(Rectangle content) {
+  for (unsigned int a = 0; a < _children.size(); a++) {
+    float x = content.x + (a % _columns) * (_cell.x + _spacing);
+    float y = content.y + (a / _columns) * (_cell.y + _spacing);
+    placeIn(_children[a], {x, y, _cell.x, _cell.y});
+  }
+}
+
 } // namespace UI
 } // namespace Theater
 
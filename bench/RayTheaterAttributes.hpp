@@ -0,0 +1,5 @@
+#ifndef STAGE_ATTRIBUTE
+#define STAGE_ATTRIBUTE(name) /**/
+#endif
+
+STAGE_ATTRIBUTE(BENCH_TAGGED)
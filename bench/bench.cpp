@@ -0,0 +1,813 @@
+// Headless benchmark suite for RayTheater
+//
+// Drives the Stage without a window (see Builder::PlayHeadless) and measures
+// the engine's hot paths with synthetic Scenes. Results are written as JSON
+// and can be compared against a stored baseline.
+//
+//   ./bench.run                               => print results as JSON
+//   ./bench.run --baseline bench/baseline.json => compare against a baseline
+//   ./bench.run --out bench/baseline.json      => store a new baseline
+//   ./bench.run --filter tick                  => only run matching benchmarks
+//   ./bench.run --threshold 1.5                => allowed slowdown factor
+//
+// Exits with 1, if any benchmark regressed beyond the threshold.
+
+// Make the render-list big enough for the render-order benchmarks
+#define ACTORLIMIT 8192
+
+#include "RayTheater.hpp"
+#include "RayTheaterCollider.hpp"
+#include "RayTheaterNavigation.hpp"
+#include "RayTheaterParticles.hpp"
+#include "RayTheaterSprites.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// BM: Helpers
+//==============================================================================
+typedef std::chrono::steady_clock BenchClock;
+
+struct BenchResult {
+  std::string name;
+  unsigned long ops;
+  double nsPerOp;
+};
+
+static std::vector<BenchResult> benchResults;
+static std::string benchFilter = "";
+
+// Keeps the optimizer from throwing away the measured work
+static volatile unsigned long benchSink = 0;
+
+static bool benchEnabled(const std::string &name) {
+  return benchFilter.empty() || name.find(benchFilter) != std::string::npos;
+}
+
+static void benchReport(const std::string &name, unsigned long ops,
+                        BenchClock::time_point start,
+                        BenchClock::time_point end) {
+  double ns =
+      std::chrono::duration<double, std::nano>(end - start).count();
+  benchResults.push_back({name, ops, ops > 0 ? ns / ops : 0});
+  std::cerr << "  " << name << ": " << (ops > 0 ? ns / ops : 0) << " ns/op"
+            << std::endl;
+}
+
+// xorshift32, so each run works on the same synthetic data
+static unsigned int benchRandState = 0x9E3779B9;
+static unsigned int benchRand() {
+  benchRandState ^= benchRandState << 13;
+  benchRandState ^= benchRandState >> 17;
+  benchRandState ^= benchRandState << 5;
+  return benchRandState;
+}
+
+static float benchRandf(float max) {
+  return (float)(benchRand() & 0xFFFF) / 65535.0f * max;
+}
+
+// BM: Actors
+//==============================================================================
+class BenchTicker : public Theater::Actor, public Theater::Ticking {
+public:
+  BenchTicker() : Theater::Actor(), Theater::Ticking(this) {}
+  unsigned long ticks = 0;
+
+private:
+  void OnTick(Theater::Play) override { ticks++; }
+};
+
+// Same as BenchTicker, but the Stage may call its OnTick directly, so
+// grouped ticks can skip the virtual call
+class BenchGroupTicker : public Theater::Actor, public Theater::Ticking {
+  friend class Theater::Stage;
+
+public:
+  BenchGroupTicker() : Theater::Actor(), Theater::Ticking(this) {}
+  unsigned long ticks = 0;
+
+private:
+  void OnTick(Theater::Play) override { ticks++; }
+};
+
+class BenchSprite : public Theater::Actor,
+                    public Theater::Visible,
+                    public Theater::Transform2D {
+public:
+  BenchSprite()
+      : Theater::Actor(), Theater::Visible(this), Theater::Transform2D(this) {}
+
+private:
+  void OnDraw(Theater::Play) override {}
+};
+
+class BenchPoint : public Theater::ColliderPoint {
+public:
+  Vector2 pos;
+  Vector2 getPosition() override { return pos; }
+};
+
+class BenchRect : public Theater::ColliderRect {
+public:
+  Rectangle rect;
+  Rectangle getRect() override { return rect; }
+};
+
+class BenchCircle : public Theater::ColliderCircle {
+public:
+  Vector2 pos;
+  float radius;
+  Vector2 getPosition() override { return pos; }
+  float getRadius() override { return radius; }
+};
+
+class BenchZone : public Theater::ColliderZone {
+public:
+  std::vector<Vector2> border;
+  std::vector<Vector2> *getZoneBorder() override { return &border; }
+};
+
+static std::vector<Vector2> benchPolygon(Vector2 center, float radius,
+                                         int corners) {
+  std::vector<Vector2> poly;
+  for (int a = 0; a < corners; a++) {
+    // Alternate the radius, to get a concave star shape
+    float r = radius * ((a & 1) ? 0.5f : 1.0f);
+    float angle = (float)a / corners * 6.2831853f;
+    poly.push_back({center.x + std::cos(angle) * r,
+                    center.y + std::sin(angle) * r});
+  }
+  return poly;
+}
+
+// BM: Scenes
+//==============================================================================
+/** @brief measures everything between the OnUpdate of the `warmup`th cycle
+ * and the end of the Scene */
+class BenchScene : public Theater::Scene {
+public:
+  BenchScene(const std::string &name, unsigned long warmup)
+      : _name(name), _warmup(warmup) {}
+
+  void OnUpdate(Theater::Play p) override {
+    if (_cycle == _warmup)
+      _start = BenchClock::now();
+
+    if (_cycle >= _warmup)
+      Measure(p);
+
+    _cycle++;
+  }
+
+  void OnEnd(Theater::Play) override {
+    benchReport(_name, _ops, _start, BenchClock::now());
+  }
+
+protected:
+  virtual void Measure(Theater::Play) {}
+  void countOps(unsigned long ops) { _ops += ops; }
+
+private:
+  std::string _name;
+  unsigned long _warmup;
+  unsigned long _cycle = 0;
+  unsigned long _ops = 0;
+  BenchClock::time_point _start;
+};
+
+static void benchRun(BenchScene *sc, unsigned long cycles) {
+  // The Builder is kept on the heap, since the Stage carries the whole
+  // render-list with it.
+  Theater::Builder *b = new Theater::Builder(480, 320);
+  b->PlayHeadless(sc, cycles);
+  delete b;
+}
+
+// BM: Scenes - Actor churn
+//------------------------------------------------------------------------------
+class ChurnScene : public BenchScene {
+public:
+  ChurnScene(unsigned long count)
+      : BenchScene("actor_churn_" + std::to_string(count), 2),
+        _actors(count) {}
+
+protected:
+  void Measure(Theater::Play p) override {
+    // Every other cycle adds all actors, the cycles between remove them
+    if (_onStage) {
+      for (BenchTicker &a : _actors)
+        p.stage->RemoveActor(&a);
+    } else {
+      for (BenchTicker &a : _actors)
+        p.stage->AddActor(&a);
+      countOps(_actors.size());
+    }
+    _onStage = !_onStage;
+  }
+
+private:
+  std::vector<BenchTicker> _actors;
+  bool _onStage = false;
+};
+
+// BM: Scenes - Tick dispatch
+//------------------------------------------------------------------------------
+// Ticks count Actors per cycle. With grouped = true, their type is
+// registered with the Stage first
+template <typename T> class TickScene : public BenchScene {
+public:
+  TickScene(std::string name, unsigned long count, bool grouped)
+      : BenchScene(name + "_" + std::to_string(count), 2), _actors(count),
+        _grouped(grouped) {}
+
+  void OnStart(Theater::Play p) override {
+    if (_grouped)
+      p.stage->RegisterActorType<T>();
+
+    for (T &a : _actors)
+      p.stage->AddActor(&a);
+  }
+
+protected:
+  void Measure(Theater::Play) override { countOps(_actors.size()); }
+
+private:
+  std::vector<T> _actors;
+  bool _grouped;
+};
+
+// BM: Scenes - Particles
+//------------------------------------------------------------------------------
+// Updates count particles per cycle, that live for the whole benchmark
+class ParticleScene : public BenchScene {
+public:
+  ParticleScene(unsigned int count, bool threaded)
+      : BenchScene(std::string(threaded ? "particles_threaded_"
+                                        : "particles_update_") +
+                       std::to_string(count),
+                   2),
+        _emitter(count) {
+    Theater::ParticleEmitter::Settings s;
+    s.rate = 0;
+    s.lifetimeMin = s.lifetimeMax = 1e6f;
+    s.acceleration = {0, 98};
+    _emitter.Setup(s)->Threaded(threaded)->Seed(1)->Burst(count);
+  }
+
+  void OnStart(Theater::Play p) override { p.stage->AddActor(&_emitter); }
+
+protected:
+  void Measure(Theater::Play) override { countOps(_emitter.Count()); }
+
+private:
+  Theater::ParticleEmitter _emitter;
+};
+
+// BM: Scenes - Sprites
+//------------------------------------------------------------------------------
+class BenchUnit : public Theater::Actor,
+                  public Theater::Transform2D,
+                  public Theater::AnimatedSprite {
+public:
+  BenchUnit() : Actor(), Transform2D(this), AnimatedSprite(this) {}
+};
+
+// Animates count sprites of one atlas per cycle
+class SpriteScene : public BenchScene {
+public:
+  SpriteScene(unsigned long count)
+      : BenchScene("sprites_animate_" + std::to_string(count), 2), _atlas(),
+        _batch(&_atlas), _units(count) {
+    _atlas.AddGrid({0, 0, 256, 256}, 8, 8);
+    _walk = _atlas.AddClip(0, 8, 12);
+  }
+
+  void OnStart(Theater::Play p) override {
+    p.stage->AddActor(&_batch);
+    for (BenchUnit &u : _units) {
+      p.stage->AddActor(&u);
+      _batch.Add(&u);
+      u.PlayClip(_walk, 0.5f + (benchRand() % 100) * 0.01f);
+    }
+  }
+
+protected:
+  void Measure(Theater::Play) override { countOps(_units.size()); }
+
+private:
+  Theater::SpriteAtlas _atlas;
+  Theater::SpriteBatch _batch;
+  std::vector<BenchUnit> _units;
+  unsigned int _walk;
+};
+
+// BM: Scenes - Tweens
+//------------------------------------------------------------------------------
+// Tweens count Vector2s per cycle, that run for the whole benchmark
+class TweenScene : public BenchScene {
+public:
+  TweenScene(unsigned long count)
+      : BenchScene("tween_update_" + std::to_string(count), 2),
+        _values(count) {}
+
+  void OnStart(Theater::Play p) override {
+    for (Vector2 &v : _values)
+      p.stage->Tweens().To(&v, {100, 100}, 1e6f, Theater::EASE_OUT_QUAD);
+  }
+
+protected:
+  void Measure(Theater::Play) override { countOps(_values.size()); }
+
+private:
+  std::vector<Vector2> _values;
+};
+
+// BM: Scenes - Render order
+//------------------------------------------------------------------------------
+class RenderOrderScene : public BenchScene {
+public:
+  RenderOrderScene(unsigned long count, int layers)
+      : BenchScene("render_order_" + std::to_string(count) + "_layers_" +
+                       std::to_string(layers),
+                   2),
+        _actors(count), _layers(layers) {}
+
+  void OnStart(Theater::Play p) override {
+    for (BenchSprite &a : _actors) {
+      p.stage->AddActor(&a);
+      a.SetRenderLayer(benchRand() % _layers);
+      p.stage->MakeActorVisible(&a);
+    }
+  }
+
+protected:
+  void Measure(Theater::Play) override {
+    // Move a few actors between layers each cycle, like a game would
+    for (int a = 0; a < 16; a++)
+      _actors[benchRand() % _actors.size()].SetRenderLayer(benchRand() %
+                                                           _layers);
+    countOps(_actors.size());
+  }
+
+private:
+  std::vector<BenchSprite> _actors;
+  int _layers;
+};
+
+// BM: Scenes - Attribute queries
+//------------------------------------------------------------------------------
+class AttributeScene : public BenchScene {
+public:
+  AttributeScene(unsigned long count, bool getList)
+      : BenchScene(std::string(getList ? "attribute_get_actors_"
+                                       : "attribute_has_") +
+                       std::to_string(count),
+                   2),
+        _actors(count), _getList(getList) {}
+
+  void OnStart(Theater::Play p) override {
+    for (unsigned long a = 0; a < _actors.size(); a++) {
+      p.stage->AddActor(&_actors[a]);
+      if (a & 1)
+        p.stage->AddActorAttribute(&_actors[a], Theater::BENCH_TAGGED);
+    }
+  }
+
+protected:
+  void Measure(Theater::Play p) override {
+    if (_getList) {
+      auto lst = p.stage->GetActorsWithAttribute(Theater::BENCH_TAGGED);
+      benchSink += lst.size();
+      countOps(1);
+    } else {
+      unsigned long found = 0;
+      for (BenchTicker &a : _actors)
+        found += a.hasAttribute(Theater::BENCH_TAGGED) ? 1 : 0;
+      benchSink += found;
+      countOps(_actors.size());
+    }
+  }
+
+private:
+  std::vector<BenchTicker> _actors;
+  bool _getList;
+};
+
+// BM: Collider benchmarks
+//==============================================================================
+#define BENCH_SHAPES 256
+
+static BenchPoint benchPoints[BENCH_SHAPES];
+static BenchRect benchRects[BENCH_SHAPES];
+static BenchCircle benchCircles[BENCH_SHAPES];
+static BenchZone benchZones[BENCH_SHAPES];
+
+static void benchPrepareShapes() {
+  for (int a = 0; a < BENCH_SHAPES; a++) {
+    benchPoints[a].pos = {benchRandf(480), benchRandf(320)};
+    benchRects[a].rect = {benchRandf(480), benchRandf(320),
+                          8 + benchRandf(56), 8 + benchRandf(56)};
+    benchCircles[a].pos = {benchRandf(480), benchRandf(320)};
+    benchCircles[a].radius = 4 + benchRandf(28);
+    benchZones[a].border =
+        benchPolygon({benchRandf(480), benchRandf(320)}, 8 + benchRandf(56), 8);
+  }
+}
+
+#define BENCH_PAIR(NAME, A, B, METHOD)                                         \
+  if (benchEnabled("collide_" NAME)) {                                         \
+    unsigned long hits = 0;                                                    \
+    auto start = BenchClock::now();                                            \
+    for (unsigned long i = 0; i < iterations; i++)                             \
+      hits += A[i % BENCH_SHAPES].METHOD(                                      \
+                  &B[(i * 7 + i / BENCH_SHAPES) % BENCH_SHAPES])               \
+                  ? 1                                                          \
+                  : 0;                                                         \
+    benchReport("collide_" NAME, iterations, start, BenchClock::now());        \
+    benchSink += hits;                                                         \
+  }
+
+static void benchColliders(unsigned long iterations) {
+  benchPrepareShapes();
+
+  BENCH_PAIR("point_point", benchPoints, benchPoints, isCollidingWithPoint)
+  BENCH_PAIR("point_rect", benchPoints, benchRects, isCollidingWithRect)
+  BENCH_PAIR("point_circle", benchPoints, benchCircles, isCollidingWithCircle)
+  BENCH_PAIR("point_zone", benchPoints, benchZones, isCollidingWithZone)
+  BENCH_PAIR("rect_rect", benchRects, benchRects, isCollidingWithRect)
+  BENCH_PAIR("rect_circle", benchRects, benchCircles, isCollidingWithCircle)
+  BENCH_PAIR("rect_zone", benchRects, benchZones, isCollidingWithZone)
+  BENCH_PAIR("circle_circle", benchCircles, benchCircles, isCollidingWithCircle)
+  BENCH_PAIR("circle_zone", benchCircles, benchZones, isCollidingWithZone)
+  BENCH_PAIR("zone_zone", benchZones, benchZones, isCollidingWithZone)
+}
+
+#undef BENCH_PAIR
+
+static void benchZonePoint(int corners, unsigned long iterations) {
+  std::string name = "zone_contains_point_" + std::to_string(corners);
+  if (!benchEnabled(name))
+    return;
+
+  std::vector<Vector2> zone = benchPolygon({240, 160}, 150, corners);
+  std::vector<Vector2> points;
+  for (int a = 0; a < BENCH_SHAPES; a++)
+    points.push_back({benchRandf(480), benchRandf(320)});
+
+  unsigned long hits = 0;
+  auto start = BenchClock::now();
+  for (unsigned long i = 0; i < iterations; i++)
+    hits += Theater::Collider::zoneContainsPoint(&zone,
+                                                 points[i % BENCH_SHAPES])
+                ? 1
+                : 0;
+  benchReport(name, iterations, start, BenchClock::now());
+  benchSink += hits;
+}
+
+// Fills a scratch vector of 64 points per op, from a FrameArena, the way a
+// frame would, and resets the arena every 1000 ops
+static void benchFrameArena(unsigned long iterations) {
+  if (!benchEnabled("frame_arena_vector_64"))
+    return;
+
+  Theater::FrameArena arena;
+  unsigned long sum = 0;
+  auto start = BenchClock::now();
+  for (unsigned long i = 0; i < iterations; i++) {
+    if (i % 1000 == 0)
+      arena.Reset();
+
+    Theater::FrameVector<Vector2> points(&arena);
+    for (int a = 0; a < 64; a++)
+      points.push_back({(float)a, (float)i});
+    sum += points.size();
+  }
+  benchReport("frame_arena_vector_64", iterations, start, BenchClock::now());
+  benchSink += sum;
+}
+
+// Casts random rays through 2000 rects and circles in a ColliderGrid
+static void benchRaycast(unsigned long iterations) {
+  std::string name = "raycast_grid_2000";
+  if (!benchEnabled(name))
+    return;
+
+  std::vector<BenchRect> rects(1000);
+  std::vector<BenchCircle> circles(1000);
+  Theater::ColliderGrid grid;
+  for (BenchRect &r : rects) {
+    r.rect = {benchRandf(4000), benchRandf(4000), 8 + benchRandf(40),
+              8 + benchRandf(40)};
+    grid.Add(&r);
+  }
+  for (BenchCircle &c : circles) {
+    c.pos = {benchRandf(4000), benchRandf(4000)};
+    c.radius = 4 + benchRandf(20);
+    grid.Add(&c);
+  }
+
+  std::vector<Theater::Ray2D> rays;
+  for (int a = 0; a < BENCH_SHAPES; a++) {
+    float angle = benchRandf(6.2831853f);
+    rays.push_back({{benchRandf(4000), benchRandf(4000)},
+                    {std::cos(angle), std::sin(angle)},
+                    INFINITY});
+  }
+
+  unsigned long hits = 0;
+  Theater::RayHit hit;
+  auto start = BenchClock::now();
+  for (unsigned long i = 0; i < iterations; i++) {
+    const Theater::Ray2D &r = rays[i % BENCH_SHAPES];
+    hits += grid.Raycast(r.origin, r.direction, r.maxDistance, &hit) ? 1 : 0;
+  }
+  benchReport(name, iterations, start, BenchClock::now());
+  benchSink += hits;
+}
+
+// Finds all colliding pairs among 2000 rects, where bullets (most of them)
+// only collide with enemies, so most candidate pairs fail the layer check
+static void benchCollidingPairs(unsigned long iterations) {
+  std::string name = "collide_pairs_grid_2000";
+  if (!benchEnabled(name))
+    return;
+
+  const unsigned int bullets = 1, enemies = 2;
+  std::vector<BenchRect> rects(2000);
+  Theater::ColliderGrid grid;
+  for (size_t a = 0; a < rects.size(); a++) {
+    BenchRect &r = rects[a];
+    r.rect = {benchRandf(2000), benchRandf(2000), 4 + benchRandf(24),
+              4 + benchRandf(24)};
+    bool bullet = a % 5 != 0;
+    r.setCollisionLayer(bullet ? bullets : enemies);
+    r.setCollisionMask(bullet ? enemies : bullets | enemies);
+    grid.Add(&r);
+  }
+
+  unsigned long pairs = 0;
+  auto start = BenchClock::now();
+  for (unsigned long i = 0; i < iterations; i++)
+    grid.ForEachCollidingPair(
+        [&pairs](Theater::Collider *, Theater::Collider *) { pairs++; });
+  benchReport(name, iterations, start, BenchClock::now());
+  benchSink += pairs;
+}
+
+// BM: Navigation benchmarks
+//==============================================================================
+// Searches paths across a 160x160 grid, cluttered with random boxes
+static void benchPaths(Theater::PathMode mode, unsigned long iterations) {
+  std::string name = std::string(mode == Theater::PATH_JPS ? "path_jps"
+                                                           : "path_astar") +
+                     "_160";
+  if (!benchEnabled(name))
+    return;
+
+  std::vector<BenchRect> boxes(300);
+  Theater::Navigator nav({0, 0, 1280, 1280}, 8);
+  for (BenchRect &b : boxes) {
+    b.rect = {benchRandf(1280), benchRandf(1280), benchRandf(80),
+              benchRandf(80)};
+    nav.AddObstacle(&b);
+  }
+
+  std::vector<Vector2> points;
+  for (int a = 0; a < BENCH_SHAPES; a++)
+    points.push_back({benchRandf(1280), benchRandf(1280)});
+
+  unsigned long found = 0;
+  auto start = BenchClock::now();
+  for (unsigned long i = 0; i < iterations; i++)
+    found += nav.FindPathNow(points[i % BENCH_SHAPES],
+                             points[(i * 7 + 1) % BENCH_SHAPES], mode)
+                 .size();
+  benchReport(name, iterations, start, BenchClock::now());
+  benchSink += found;
+}
+
+// Builds flow fields across a 160x160 grid from scratch (repair = false), or
+// moves one box each iteration and lets the field repair itself
+static void benchFlowField(bool repair, unsigned long iterations) {
+  std::string name = repair ? "flow_repair_160" : "flow_field_160";
+  if (!benchEnabled(name))
+    return;
+
+  std::vector<BenchRect> boxes(300);
+  Theater::Navigator nav({0, 0, 1280, 1280}, 8);
+  for (BenchRect &b : boxes) {
+    b.rect = {benchRandf(1280), benchRandf(1280), benchRandf(80),
+              benchRandf(80)};
+    nav.AddObstacle(&b);
+  }
+
+  unsigned long reachable = 0;
+  auto start = BenchClock::now();
+  for (unsigned long i = 0; i < iterations; i++) {
+    if (repair) {
+      BenchRect &b = boxes[i % boxes.size()];
+      b.rect.x = benchRandf(1280);
+      nav.ObstacleChanged(&b);
+      nav.IsBlocked({0, 0}); // applies the change
+    }
+
+    // Fresh goals don't hit the cache
+    Vector2 goal = repair ? Vector2{640, 640} : Vector2{(float)(i * 8 % 1280),
+                                                         640};
+    reachable += nav.GetFlowField(goal)->Reachable({0, 0}) ? 1 : 0;
+  }
+  benchReport(name, iterations, start, BenchClock::now());
+  benchSink += reachable;
+}
+
+// BM: Baseline
+//==============================================================================
+static std::map<std::string, double> benchLoadBaseline(const char *path) {
+  std::map<std::string, double> baseline;
+  std::ifstream in(path);
+  if (!in.good()) {
+    std::cerr << "could not read baseline '" << path << "'" << std::endl;
+    return baseline;
+  }
+
+  std::stringstream buf;
+  buf << in.rdbuf();
+  std::string json = buf.str();
+
+  // The baseline is a previous output of this program, so it is enough to
+  // look for each "name" followed by its "ns_per_op"
+  size_t pos = 0;
+  while ((pos = json.find("\"name\"", pos)) != std::string::npos) {
+    size_t nameStart = json.find('"', json.find(':', pos)) + 1;
+    size_t nameEnd = json.find('"', nameStart);
+    size_t valPos = json.find("\"ns_per_op\"", nameEnd);
+    if (valPos == std::string::npos)
+      break;
+
+    valPos = json.find(':', valPos) + 1;
+    baseline[json.substr(nameStart, nameEnd - nameStart)] =
+        std::strtod(json.c_str() + valPos, NULL);
+    pos = valPos;
+  }
+
+  return baseline;
+}
+
+static int benchWriteJSON(std::ostream &out,
+                          std::map<std::string, double> &baseline,
+                          double threshold) {
+  int regressions = 0;
+
+  out << "{\n  \"suite\": \"raytheater\",\n  \"threshold\": " << threshold
+      << ",\n  \"results\": [";
+
+  for (size_t a = 0; a < benchResults.size(); a++) {
+    BenchResult &r = benchResults[a];
+    out << (a == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.name
+        << "\", \"ops\": " << r.ops << ", \"ns_per_op\": " << r.nsPerOp;
+
+    auto base = baseline.find(r.name);
+    if (base != baseline.end() && base->second > 0) {
+      double ratio = r.nsPerOp / base->second;
+      const char *status = "ok";
+      if (ratio > threshold) {
+        status = "regressed";
+        regressions++;
+      } else if (ratio < 1.0 / threshold) {
+        status = "improved";
+      }
+
+      out << ", \"baseline_ns_per_op\": " << base->second
+          << ", \"ratio\": " << ratio << ", \"status\": \"" << status << "\"";
+    } else if (!baseline.empty()) {
+      out << ", \"status\": \"new\"";
+    }
+
+    out << "}";
+  }
+
+  out << "\n  ],\n  \"regressions\": " << regressions << "\n}\n";
+  return regressions;
+}
+
+// BM: Main
+//==============================================================================
+int main(int argc, char **argv) {
+  const char *baselinePath = NULL;
+  const char *outPath = NULL;
+  double threshold = 1.5;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--baseline") == 0 && a + 1 < argc)
+      baselinePath = argv[++a];
+    else if (strcmp(argv[a], "--out") == 0 && a + 1 < argc)
+      outPath = argv[++a];
+    else if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc)
+      benchFilter = argv[++a];
+    else if (strcmp(argv[a], "--threshold") == 0 && a + 1 < argc)
+      threshold = std::strtod(argv[++a], NULL);
+    else {
+      std::cerr << "usage: " << argv[0]
+                << " [--baseline file] [--out file] [--filter name]"
+                   " [--threshold factor]"
+                << std::endl;
+      return 2;
+    }
+  }
+
+  std::cerr << "RayTheater benchmarks:" << std::endl;
+
+  unsigned long churnCounts[] = {1000, 10000};
+  for (unsigned long n : churnCounts) {
+    ChurnScene sc(n);
+    if (benchEnabled("actor_churn_" + std::to_string(n)))
+      benchRun(&sc, 2 + 100);
+  }
+
+  unsigned long tickCounts[] = {1000, 10000, 100000};
+  for (unsigned long n : tickCounts) {
+    TickScene<BenchTicker> sc("tick_dispatch", n, false);
+    if (benchEnabled("tick_dispatch_" + std::to_string(n)))
+      benchRun(&sc, 2 + 20000000 / n);
+  }
+
+  for (unsigned long n : tickCounts) {
+    TickScene<BenchGroupTicker> sc("tick_grouped", n, true);
+    if (benchEnabled("tick_grouped_" + std::to_string(n)))
+      benchRun(&sc, 2 + 20000000 / n);
+  }
+
+  {
+    ParticleScene single(200000, false);
+    if (benchEnabled("particles_update_200000"))
+      benchRun(&single, 2 + 200);
+
+    ParticleScene threaded(200000, true);
+    if (benchEnabled("particles_threaded_200000"))
+      benchRun(&threaded, 2 + 200);
+  }
+
+  {
+    SpriteScene sc(10000);
+    if (benchEnabled("sprites_animate_10000"))
+      benchRun(&sc, 2 + 1000);
+  }
+
+  {
+    TweenScene sc(100000);
+    if (benchEnabled("tween_update_100000"))
+      benchRun(&sc, 2 + 200);
+  }
+
+  unsigned long renderCounts[] = {1000, 8000};
+  for (unsigned long n : renderCounts) {
+    RenderOrderScene sc(n, 16);
+    if (benchEnabled("render_order_" + std::to_string(n)))
+      benchRun(&sc, 2 + 200000 / n);
+  }
+
+  {
+    AttributeScene get(10000, true);
+    if (benchEnabled("attribute_get_actors_10000"))
+      benchRun(&get, 2 + 200);
+
+    AttributeScene has(10000, false);
+    if (benchEnabled("attribute_has_10000"))
+      benchRun(&has, 2 + 200);
+  }
+
+  benchColliders(2000000);
+  benchZonePoint(8, 2000000);
+  benchZonePoint(64, 500000);
+  benchFrameArena(200000);
+  benchRaycast(100000);
+  benchCollidingPairs(200);
+  benchPaths(Theater::PATH_ASTAR, 500);
+  benchPaths(Theater::PATH_JPS, 500);
+  benchFlowField(false, 50);
+  benchFlowField(true, 200);
+
+  std::map<std::string, double> baseline;
+  if (baselinePath != NULL)
+    baseline = benchLoadBaseline(baselinePath);
+
+  int regressions = benchWriteJSON(std::cout, baseline, threshold);
+
+  if (outPath != NULL) {
+    std::ofstream out(outPath);
+    std::map<std::string, double> none;
+    benchWriteJSON(out, none, threshold);
+  }
+
+  if (regressions > 0)
+    std::cerr << regressions << " benchmark(s) regressed" << std::endl;
+
+  return regressions > 0 ? 1 : 0;
+}